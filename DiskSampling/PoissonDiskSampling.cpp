@@ -2,6 +2,8 @@
 
 #include <random>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 PoissonDiskSampling::PoissonDiskSampling(int pointWidth, int pointHeight, double pointMinDist, double pointCount) :
 	m_width(pointWidth),
@@ -12,7 +14,7 @@ PoissonDiskSampling::PoissonDiskSampling(int pointWidth, int pointHeight, double
 	m_gridWidth(static_cast<int>(ceil(m_width / m_cellSize))),
 	m_gridHeight(static_cast<int>(ceil(m_height / m_cellSize)))
 {
-	m_grid = std::vector<std::vector<Point*>>(m_gridWidth, std::vector<Point*>(m_gridHeight, nullptr));
+	m_grid = std::vector<Point>(m_gridWidth * m_gridHeight, Point(-1.0, -1.0));
 }
 
 std::vector<std::pair<double, double>> PoissonDiskSampling::Generate()
@@ -24,27 +26,24 @@ std::vector<std::pair<double, double>> PoissonDiskSampling::Generate()
 
 	m_process.push_back(firstPoint);
 	m_sample.push_back(std::make_pair(firstPoint.x, firstPoint.y));
-	int firstPointX = static_cast<int>(firstPoint.x / m_cellSize);
-	int firstPointY = static_cast<int>(firstPoint.y / m_cellSize);
-	m_grid[firstPointX][firstPointY] = new Point(firstPoint);
+	m_grid[firstPoint.GetGridIndex(m_cellSize, m_gridWidth)] = firstPoint;
 
 	while (!m_process.empty())
 	{
 		int newPointIndex = gen() % m_process.size();
 		Point newPoint = m_process[newPointIndex];
-		m_process.erase(m_process.begin() + newPointIndex);
+		m_process[newPointIndex] = m_process.back();
+		m_process.pop_back();
 
 		for (int i = 0; i < m_pointCount; ++i)
 		{
-			Point newPointAround = GeneratePointAround(newPoint);
+			Point newPointAround = GeneratePointAround(newPoint, gen);
 
 			if (IsInRectangle(newPointAround) && !IsInNeighbourhood(newPointAround))
 			{
 				m_process.push_back(newPointAround);
 				m_sample.push_back(std::make_pair(newPointAround.x, newPointAround.y));
-				int newPointX = static_cast<int>(newPointAround.x / m_cellSize);
-				int newPointY = static_cast<int>(newPointAround.y / m_cellSize);
-				m_grid[newPointX][newPointY] = new Point(newPointAround);
+				m_grid[newPointAround.GetGridIndex(m_cellSize, m_gridWidth)] = newPointAround;
 			}
 		}
 	}
@@ -52,11 +51,151 @@ std::vector<std::pair<double, double>> PoissonDiskSampling::Generate()
 	return m_sample;
 }
 
-PoissonDiskSampling::Point PoissonDiskSampling::GeneratePointAround(Point p) const
+std::vector<std::pair<double, double>> PoissonDiskSampling::Generate(unsigned int seed, unsigned int threadCount)
 {
-	std::random_device rd;
-	std::mt19937 gen(rd());
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	const int tilesX = (m_gridWidth + TILE_CELLS - 1) / TILE_CELLS;
+	const int tilesY = (m_gridHeight + TILE_CELLS - 1) / TILE_CELLS;
+	std::vector<std::vector<Point>> tilePoints(tilesX * tilesY);
+
+	for (int phase = 0; phase < 4; ++phase)
+	{
+		std::vector<int> tiles;
+		for (int ty = phase / 2; ty < tilesY; ty += 2)
+		{
+			for (int tx = phase % 2; tx < tilesX; tx += 2)
+			{
+				tiles.push_back(tx + ty * tilesX);
+			}
+		}
+
+		std::atomic<size_t> nextTile(0);
+		auto worker = [&]()
+		{
+			for (size_t i = nextTile++; i < tiles.size(); i = nextTile++)
+			{
+				int tile = tiles[i];
+				GenerateTile(seed, tile % tilesX, tile / tilesX, tilePoints[tile]);
+			}
+		};
+
+		unsigned int numThreads = std::min(threadCount, static_cast<unsigned int>(tiles.size()));
+		std::vector<std::thread> threads;
+
+		for (unsigned int t = 1; t < numThreads; ++t)
+		{
+			threads.push_back(std::thread(worker));
+		}
+
+		worker();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	m_sample.clear();
+	for (const auto& points : tilePoints)
+	{
+		for (const auto& p : points)
+		{
+			m_sample.push_back(std::make_pair(p.x, p.y));
+		}
+	}
+
+	return m_sample;
+}
+
+void PoissonDiskSampling::GenerateTile(unsigned int seed, int tileX, int tileY, std::vector<Point>& points)
+{
+	std::seed_seq seq = { seed, static_cast<unsigned int>(tileX), static_cast<unsigned int>(tileY) };
+	std::mt19937 gen(seq);
+
+	const int minCellX = tileX * TILE_CELLS;
+	const int minCellY = tileY * TILE_CELLS;
+	const int maxCellX = std::min(minCellX + TILE_CELLS, m_gridWidth) - 1;
+	const int maxCellY = std::min(minCellY + TILE_CELLS, m_gridHeight) - 1;
+
+	auto isInTile = [&](Point p)
+	{
+		if (!IsInRectangle(p))
+		{
+			return false;
+		}
+
+		int cellX = static_cast<int>(p.x / m_cellSize);
+		int cellY = static_cast<int>(p.y / m_cellSize);
+
+		return cellX >= minCellX && cellX <= maxCellX && cellY >= minCellY && cellY <= maxCellY;
+	};
+
+	auto accept = [&](Point p)
+	{
+		m_grid[p.GetGridIndex(m_cellSize, m_gridWidth)] = p;
+		points.push_back(p);
+	};
 
+	// Grow from the points already placed around the tile by earlier phases so the seams get filled
+	std::vector<Point> process;
+
+	for (int y = std::max(0, minCellY - 2); y <= std::min(m_gridHeight - 1, maxCellY + 2); ++y)
+	{
+		for (int x = std::max(0, minCellX - 2); x <= std::min(m_gridWidth - 1, maxCellX + 2); ++x)
+		{
+			const Point& p = m_grid[x + y * m_gridWidth];
+			if (!p.IsEmpty())
+			{
+				process.push_back(p);
+			}
+		}
+	}
+
+	double tileMinX = minCellX * m_cellSize;
+	double tileMinY = minCellY * m_cellSize;
+	double tileWidth = std::min(m_width - tileMinX, TILE_CELLS * m_cellSize);
+	double tileHeight = std::min(m_height - tileMinY, TILE_CELLS * m_cellSize);
+
+	for (int i = 0; i < m_pointCount; ++i)
+	{
+		double r1 = static_cast<double>(gen()) / gen.max();
+		double r2 = static_cast<double>(gen()) / gen.max();
+		Point seedPoint(tileMinX + tileWidth * r1, tileMinY + tileHeight * r2);
+
+		if (isInTile(seedPoint) && !IsInNeighbourhood(seedPoint, 2))
+		{
+			accept(seedPoint);
+			process.push_back(seedPoint);
+			break;
+		}
+	}
+
+	while (!process.empty())
+	{
+		int index = gen() % process.size();
+		Point point = process[index];
+		process[index] = process.back();
+		process.pop_back();
+
+		for (int i = 0; i < m_pointCount; ++i)
+		{
+			Point newPoint = GeneratePointAround(point, gen);
+
+			if (isInTile(newPoint) && !IsInNeighbourhood(newPoint, 2))
+			{
+				accept(newPoint);
+				process.push_back(newPoint);
+			}
+		}
+	}
+}
+
+PoissonDiskSampling::Point PoissonDiskSampling::GeneratePointAround(Point p, std::mt19937& gen) const
+{
 	double r1 = static_cast<double>(gen()) / gen.max();
 	double r2 = static_cast<double>(gen()) / gen.max();
 
@@ -90,6 +229,32 @@ bool PoissonDiskSampling::IsInNeighbourhood(Point p)
 	return false;
 }
 
+bool PoissonDiskSampling::IsInNeighbourhood(Point p, int radius) const
+{
+	int indexX = static_cast<int>(p.x / m_cellSize);
+	int indexY = static_cast<int>(p.y / m_cellSize);
+
+	int minX = std::max(0, indexX - radius);
+	int maxX = std::min(m_gridWidth - 1, indexX + radius);
+
+	int minY = std::max(0, indexY - radius);
+	int maxY = std::min(m_gridHeight - 1, indexY + radius);
+
+	for (int j = minY; j <= maxY; ++j)
+	{
+		for (int i = minX; i <= maxX; ++i)
+		{
+			const Point& cell = m_grid[i + j * m_gridWidth];
+			if (!cell.IsEmpty() && cell.Distance(p) < m_minDist)
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
 std::vector<PoissonDiskSampling::Point*> PoissonDiskSampling::GetCellsAround(Point p)
 {
 	std::vector<Point*> cells;
@@ -107,9 +272,10 @@ std::vector<PoissonDiskSampling::Point*> PoissonDiskSampling::GetCellsAround(Poi
 	{
 		for (int j = minY; j <= maxY; ++j)
 		{
-			if (m_grid[i][j] != nullptr)
+			Point& cell = m_grid[i + j * m_gridWidth];
+			if (!cell.IsEmpty())
 			{
-				cells.push_back(m_grid[i][j]);
+				cells.push_back(&cell);
 			}
 		}
 	}
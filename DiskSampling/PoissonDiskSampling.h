@@ -2,6 +2,7 @@
 #define POISSON_DISK_SAMPLING_H
 
 #include <vector>
+#include <random>
 
 class PoissonDiskSampling
 {
@@ -19,6 +20,13 @@ public:
 
 	std::vector<std::pair<double, double>> Generate();
 
+	// Tiled parallel sampling.
+	// The grid is split into fixed-size tiles processed in four checkerboard phases,
+	// so tiles running concurrently never touch each other's cells. Each tile draws
+	// from its own generator seeded by (seed, tile), which makes the result depend
+	// only on the seed and not on the number of threads (0 = hardware concurrency).
+	std::vector<std::pair<double, double>> Generate(unsigned int seed, unsigned int threadCount);
+
 	struct Point
 	{
 		Point() : x(0.0), y(0.0) { }
@@ -67,11 +75,18 @@ public:
 			return sqrt((x - p.x) * (x - p.x) + (y - p.y) * (y - p.y));
 		}
 
+		bool IsEmpty() const
+		{
+			return x < 0.0;
+		}
+
 		double x, y;
 	};
 
 private:
-	std::vector<std::vector<Point*>> m_grid;
+	static const int TILE_CELLS = 16;
+
+	std::vector<Point> m_grid;
 	std::vector<Point> m_process;
 	std::vector<std::pair<double, double>> m_sample;
 
@@ -83,10 +98,12 @@ private:
 	int m_gridWidth;
 	int m_gridHeight;
 
-	Point GeneratePointAround(Point p) const;
+	Point GeneratePointAround(Point p, std::mt19937& gen) const;
 	bool IsInRectangle(Point p) const;
 	bool IsInNeighbourhood(Point p);
+	bool IsInNeighbourhood(Point p, int radius) const;
 	std::vector<Point*> GetCellsAround(Point p);
+	void GenerateTile(unsigned int seed, int tileX, int tileY, std::vector<Point>& points);
 };
 
 #endif
\ No newline at end of file
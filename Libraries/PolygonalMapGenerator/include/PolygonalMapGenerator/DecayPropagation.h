@@ -0,0 +1,55 @@
+#ifndef DECAY_PROPAGATION_H
+#define DECAY_PROPAGATION_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+// Spreads values over an adjacency: a source, or a vertex raised by a neighbour, raises every neighbour
+// to its own value times decay, until no value can be raised any more.
+// Level-synchronous: the frontier of a level is relaxed in parallel with an atomic max on the values
+// and the vertices it raised form the next frontier. The result is the same fixed point as a serial FIFO,
+// whatever the thread count, and a pool of one thread runs that FIFO directly.
+// Values must not be negative, so that their bits order like the doubles.
+class DecayPropagation
+{
+public:
+	DecayPropagation();
+
+	~DecayPropagation() = default;
+
+	DecayPropagation(const DecayPropagation& propagation) = delete;
+	DecayPropagation(DecayPropagation&& propagation) = delete;
+
+	DecayPropagation& operator=(const DecayPropagation& propagation) = delete;
+	DecayPropagation& operator=(DecayPropagation&& propagation) = delete;
+
+	// Updates values in place, decay must be in [0, 1)
+	void Propagate(const Adjacency& adjacency, std::vector<double>& values, const std::vector<unsigned int>& sources, double decay, ThreadPool& pool);
+
+	// Vertices queued by the last propagation, sources included
+	unsigned int GetPushCount() const;
+
+private:
+	void Reserve(unsigned int vertexCount);
+	void PropagateSerial(const Adjacency& adjacency, std::vector<double>& values, const std::vector<unsigned int>& sources, double decay);
+	// Relaxes m_frontier[begin, end) and appends the vertices it raised to next
+	void RelaxSerial(const Adjacency& adjacency, double decay, unsigned int begin, unsigned int end, std::vector<unsigned int>& next);
+	void RelaxParallel(const Adjacency& adjacency, double decay, unsigned int begin, unsigned int end, std::vector<unsigned int>& next);
+
+	// Bits of the values, so that they can be raised with a compare and swap
+	std::unique_ptr<std::atomic<uint64_t>[]> m_values;
+	// Set while a vertex waits in the next frontier, so that it is queued once per level
+	std::unique_ptr<std::atomic<bool>[]> m_queued;
+	unsigned int m_capacity;
+	std::vector<unsigned int> m_frontier;
+	// Next frontier of every block of the current level
+	std::vector<std::vector<unsigned int>> m_blockFrontiers;
+	unsigned int m_pushCount;
+};
+
+#endif
\ No newline at end of file
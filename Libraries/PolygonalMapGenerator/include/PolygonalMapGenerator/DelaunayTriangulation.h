@@ -2,11 +2,14 @@
 #define DELAUNAY_TRIANGULATION_H
 
 #include <set>
+#include <vector>
 #include <cassert>
 
 namespace DelaunayTriangulation
 {
 	const double EPSILON = 1.192092896e-07F;
+	// Half-edge without a twin, on the convex hull
+	const unsigned int NO_HALF_EDGE = 0xFFFFFFFF;
 
 	struct Point
 	{
@@ -253,14 +256,39 @@ namespace DelaunayTriangulation
 	using EdgeIterator = std::set<Edge>::iterator;
 	using cEdgeIterator = std::set<Edge>::const_iterator;
 
+	// Triangulation backends.
+	// BowyerWatson is the original incremental algorithm with a super triangle (O(n^2) in practice).
+	// SweepHull sorts the vertices radially around a seed triangle and grows a convex hull,
+	// legalizing new triangles with edge flips (O(n log n)).
+	enum class Algorithm
+	{
+		BowyerWatson,
+		SweepHull
+	};
+
 	class Delaunay
 	{
 	public:
+		Delaunay() : m_algorithm(Algorithm::SweepHull) { }
+		explicit Delaunay(Algorithm algorithm) : m_algorithm(algorithm) { }
+
+		Algorithm GetAlgorithm() const { return m_algorithm; }
+		void SetAlgorithm(Algorithm algorithm) { m_algorithm = algorithm; }
+
 		void Triangulate(const VertexSet& vertices, TriangleSet& output);
+		// Index-based variant: three indices into vertices per triangle, no Vertex pointers to resolve
+		void Triangulate(const std::vector<Vertex>& vertices, std::vector<unsigned int>& triangles);
+		// Also returns the twin of every half-edge, where half-edge 3 * t + k goes from
+		// triangles[3 * t + k] to triangles[3 * t + (k + 1) % 3], NO_HALF_EDGE on the hull
+		void Triangulate(const std::vector<Vertex>& vertices, std::vector<unsigned int>& triangles, std::vector<unsigned int>& halfEdges);
 		void TrianglesToEdges(const TriangleSet& triangles, EdgeSet& edges);
 
 	private:
+		void TriangulateBowyerWatson(const VertexSet& vertices, TriangleSet& output);
+		void TriangulateSweepHull(const VertexSet& vertices, TriangleSet& output);
 		void HandleEdge(const Vertex* p0, const Vertex* p1, EdgeSet& edges);
+
+		Algorithm m_algorithm;
 	};
 }
 
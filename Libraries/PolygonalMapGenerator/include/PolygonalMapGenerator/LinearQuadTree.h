@@ -0,0 +1,80 @@
+#ifndef LINEAR_QUAD_TREE_H
+#define LINEAR_QUAD_TREE_H
+
+#include <vector>
+
+#include "Math/AABB.h"
+#include "Math/Vector2.h"
+
+// Complete quadtree of a fixed depth stored in flat arrays.
+// The leaves are numbered by the Morton code of their cell, so every node of every level covers
+// a contiguous range of leaves and is addressed by its level and code instead of by pointers.
+// Elements are bulk-built into every leaf their bounding box overlaps, in one contiguous array
+// grouped by leaf in Morton order, and each tree keeps its own depth.
+// Every element also has a position, and is listed in the leaf of its position as well;
+// the queries report an element from a single leaf, so results never hold duplicates.
+class LinearQuadTree
+{
+public:
+	// Deepest tree that can be built, 4^12 leaves
+	static const unsigned int MAX_DEPTH = 12;
+
+	LinearQuadTree();
+
+	~LinearQuadTree() = default;
+
+	LinearQuadTree(const LinearQuadTree& tree) = delete;
+	LinearQuadTree(LinearQuadTree&& tree) = delete;
+
+	LinearQuadTree& operator=(const LinearQuadTree& tree) = delete;
+	LinearQuadTree& operator=(LinearQuadTree&& tree) = delete;
+
+	// Covers boundary with 4^depth leaves, element i is bounded by bounds[i] and located at positions[i]
+	void Build(const std::vector<AABB>& bounds, const std::vector<Vector2>& positions, AABB boundary, unsigned int depth);
+	void Clear();
+
+	// The queries fill elements, which keeps its capacity from one query to the next
+
+	// Elements whose bounds contain position
+	void QueryPoint(Vector2 position, std::vector<unsigned int>& elements) const;
+	// Elements whose bounds intersect range
+	void QueryRange(const AABB& range, std::vector<unsigned int>& elements) const;
+	// Elements whose position is within radius of position
+	void QueryRadius(Vector2 position, double radius, std::vector<unsigned int>& elements) const;
+	// The count elements whose positions are closest to position, closest first and lowest index first on ties.
+	// Searches rings of leaves around position and keeps the result sorted by insertion, meant for small counts.
+	void QueryNearest(Vector2 position, unsigned int count, std::vector<unsigned int>& elements) const;
+
+	unsigned int GetDepth() const;
+	const AABB& GetBoundary() const;
+	unsigned int GetElementCount() const;
+
+	// Interleaves the bits of x and y, x in the even bits, both below 2^16
+	static unsigned int EncodeMorton(unsigned int x, unsigned int y);
+
+private:
+	unsigned int GetLeafCount() const;
+	// Leaf holding position, or GetLeafCount() outside the boundary
+	unsigned int GetLeaf(Vector2 position) const;
+	// Leaf column and row of a coordinate, clamped to the tree
+	unsigned int GetColumn(double x) const;
+	unsigned int GetRow(double y) const;
+
+	AABB m_boundary;
+	Vector2 m_origin;
+	Vector2 m_leafSize;
+	Vector2 m_inverseLeafSize;
+	unsigned int m_depth;
+	unsigned int m_side;
+
+	std::vector<AABB> m_bounds;
+	std::vector<Vector2> m_positions;
+	// Leaf of the position of every element, clamped to the tree
+	std::vector<unsigned int> m_homeLeaves;
+	// Elements of leaf l are m_leafElements[m_leafOffsets[l]] ... m_leafElements[m_leafOffsets[l + 1] - 1],
+	// so the elements of any node are one range as well
+	std::vector<unsigned int> m_leafOffsets;
+	std::vector<unsigned int> m_leafElements;
+};
+
+#endif
\ No newline at end of file
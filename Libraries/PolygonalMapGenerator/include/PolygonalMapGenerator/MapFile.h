@@ -0,0 +1,188 @@
+#ifndef MAP_FILE_H
+#define MAP_FILE_H
+
+#include <string>
+#include <cstdint>
+
+#include "Span.h"
+#include "Structure.h"
+
+// Forward Declaration
+struct Mesh;
+struct MapAttributes;
+
+// Sections of a map file, each one a raw array
+enum class MapFileSection : uint32_t
+{
+	CenterPositions,
+	CornerPositions,
+
+	CenterCentersOffsets,
+	CenterCentersIndices,
+	CenterCornersOffsets,
+	CenterCornersIndices,
+	CenterEdgesOffsets,
+	CenterEdgesIndices,
+
+	CornerCornersOffsets,
+	CornerCornersIndices,
+	CornerCentersOffsets,
+	CornerCentersIndices,
+	CornerEdgesOffsets,
+	CornerEdgesIndices,
+
+	EdgeCenters,
+	EdgeCorners,
+
+	CenterElevation,
+	CenterMoisture,
+	CenterBiome,
+	CenterWater,
+	CenterOcean,
+	CenterCoast,
+	CenterBorder,
+
+	CornerElevation,
+	CornerMoisture,
+	CornerRiverVolume,
+	CornerDownslope,
+	CornerDownslopeEdge,
+	CornerWater,
+	CornerOcean,
+	CornerCoast,
+	CornerBorder,
+
+	EdgeRiverVolume,
+
+	Size
+};
+
+struct MapFilePoint
+{
+	double x;
+	double y;
+};
+
+struct MapFileHeader
+{
+	char m_magic[4];
+	uint32_t m_version;
+	uint32_t m_byteOrder;
+	uint32_t m_sectionCount;
+	uint32_t m_centerCount;
+	uint32_t m_cornerCount;
+	uint32_t m_edgeCount;
+	uint32_t m_reserved;
+	uint64_t m_graphHash;
+};
+
+struct MapFileSectionEntry
+{
+	uint32_t m_id;
+	uint32_t m_elementSize;
+	uint64_t m_count;
+	uint64_t m_offset;
+};
+
+// Read-only view of a CSR adjacency stored in a map file
+struct MapFileAdjacency
+{
+	const uint32_t* Begin(uint32_t i) const { return m_indices.Data() + m_offsets[i]; }
+	const uint32_t* End(uint32_t i) const { return m_indices.Data() + m_offsets[i + 1]; }
+	uint32_t Size(uint32_t i) const { return m_offsets[i + 1] - m_offsets[i]; }
+
+	Span<const uint32_t> m_offsets;
+	Span<const uint32_t> m_indices;
+};
+
+// Read-only view of a flag channel stored in a map file
+struct MapFileFlags
+{
+	bool Test(size_t i) const { return (m_words[i >> 6] >> (i & 63)) & 1; }
+
+	Span<const uint64_t> m_words;
+};
+
+// Versioned binary map format.
+// The file is a header, a section table and the sections themselves, each one
+// the raw array of an index mesh or attribute channel aligned to 8 bytes.
+// Open() memory-maps the file and hands out views straight into the mapping,
+// so loading needs neither per-element allocation nor pointer fix-ups.
+// A file whose sections do not match the element counts of its header is rejected.
+class MapFile
+{
+public:
+	static const uint32_t VERSION = 2;
+
+	MapFile();
+
+	~MapFile();
+
+	MapFile(const MapFile& mapFile) = delete;
+	MapFile(MapFile&& mapFile) = delete;
+
+	MapFile& operator=(const MapFile& mapFile) = delete;
+	MapFile& operator=(MapFile&& mapFile) = delete;
+
+	static bool Write(const std::string& path, const Mesh& mesh, const MapAttributes& attributes, uint64_t graphHash);
+
+	bool Open(const std::string& path);
+	void Close();
+	bool IsOpen() const;
+
+	const MapFileHeader& GetHeader() const;
+
+	Span<const MapFilePoint> GetCenterPositions() const;
+	Span<const MapFilePoint> GetCornerPositions() const;
+
+	MapFileAdjacency GetCenterCenters() const;
+	MapFileAdjacency GetCenterCorners() const;
+	MapFileAdjacency GetCenterEdges() const;
+	MapFileAdjacency GetCornerCorners() const;
+	MapFileAdjacency GetCornerCenters() const;
+	MapFileAdjacency GetCornerEdges() const;
+
+	// Two entries per edge, Mesh::INVALID_INDEX if missing
+	Span<const uint32_t> GetEdgeCenters() const;
+	Span<const uint32_t> GetEdgeCorners() const;
+
+	Span<const double> GetCenterElevations() const;
+	Span<const double> GetCenterMoistures() const;
+	BiomeType GetCenterBiome(uint32_t i) const;
+	MapFileFlags GetCenterFlags(MapFileSection section) const;
+
+	Span<const double> GetCornerElevations() const;
+	Span<const double> GetCornerMoistures() const;
+	Span<const double> GetCornerRiverVolumes() const;
+	Span<const uint32_t> GetCornerDownslopes() const;
+	Span<const uint32_t> GetCornerDownslopeEdges() const;
+	MapFileFlags GetCornerFlags(MapFileSection section) const;
+
+	Span<const double> GetEdgeRiverVolumes() const;
+
+private:
+	template <typename T>
+	Span<const T> GetSection(MapFileSection section) const;
+
+	MapFileAdjacency GetAdjacency(MapFileSection offsets, MapFileSection indices) const;
+
+	// Checks the sizes of the sections against the header and the indices they hold,
+	// so that the views handed out never read past their sections or their targets
+	bool Validate() const;
+	bool ValidateAdjacency(MapFileSection offsets, MapFileSection indices, uint32_t targetCount) const;
+	bool ValidateIndices(MapFileSection section, uint32_t targetCount) const;
+	bool ValidateBiomes() const;
+
+	const unsigned char* m_data;
+	size_t m_size;
+	const MapFileSectionEntry* m_sections;
+
+#ifdef _WIN32
+	void* m_file;
+	void* m_mapping;
+#else
+	int m_file;
+#endif
+};
+
+#endif
\ No newline at end of file
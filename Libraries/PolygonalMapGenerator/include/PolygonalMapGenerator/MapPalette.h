@@ -0,0 +1,89 @@
+#ifndef MAP_PALETTE_H
+#define MAP_PALETTE_H
+
+#include <cstdint>
+
+#include "Structure.h"
+
+// Attribute shown by the cell colors of a rendered map
+enum class MapView
+{
+	Elevation,
+	Moisture,
+	Biomes
+};
+
+struct MapColor
+{
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+	uint8_t a;
+};
+
+// Colors of the rendered maps, shared by the viewer and the headless rasterizer
+namespace MapPalette
+{
+	const MapColor VORONOI = { 52, 58, 94, 127 };
+	const MapColor WATER = { 52, 58, 94, 255 };
+	const MapColor LAND = { 178, 166, 148, 255 };
+	const MapColor LAKE = { 95, 134, 169, 255 };
+	const MapColor RIVER = { 40, 88, 132, 255 };
+	const MapColor BACKGROUND = { 255, 255, 255, 255 };
+
+	// Tenths of elevation, from the lowest land up
+	const MapColor ELEVATION[] =
+	{
+		{ 104, 134, 89, 255 },
+		{ 119, 153, 102, 255 },
+		{ 136, 166, 121, 255 },
+		{ 153, 179, 148, 255 },
+		{ 170, 191, 159, 255 },
+		{ 187, 204, 179, 255 },
+		{ 204, 217, 198, 255 },
+		{ 221, 230, 217, 255 },
+		{ 238, 242, 236, 255 },
+		{ 251, 252, 251, 255 }
+	};
+
+	// Tenths of moisture, from the driest land up
+	const MapColor MOISTURE[] =
+	{
+		{ 238, 238, 32, 255 },
+		{ 218, 238, 32, 255 },
+		{ 197, 238, 32, 255 },
+		{ 176, 238, 32, 255 },
+		{ 155, 238, 32, 255 },
+		{ 135, 238, 32, 255 },
+		{ 115, 238, 32, 255 },
+		{ 94, 238, 32, 255 },
+		{ 73, 238, 32, 255 },
+		{ 52, 238, 32, 255 },
+		{ 32, 238, 32, 255 }
+	};
+
+	// Indexed by BiomeType
+	const MapColor BIOME[] =
+	{
+		{ 248, 248, 248, 255 },
+		{ 221, 221, 187, 255 },
+		{ 153, 153, 153, 255 },
+		{ 204, 212, 187, 255 },
+		{ 196, 204, 187, 255 },
+		{ 228, 232, 202, 255 },
+		{ 164, 196, 168, 255 },
+		{ 180, 201, 169, 255 },
+		{ 196, 212, 170, 255 },
+		{ 156, 187, 169, 255 },
+		{ 169, 204, 164, 255 },
+		{ 233, 221, 199, 255 },
+		{ 52, 58, 94, 255 },
+		{ 95, 134, 169, 255 },
+		{ 178, 166, 148, 255 }
+	};
+
+	// Fill color of a center in the given view
+	MapColor GetCenterColor(MapView view, BiomeType biome, double elevation, double moisture, bool water, bool ocean);
+}
+
+#endif
\ No newline at end of file
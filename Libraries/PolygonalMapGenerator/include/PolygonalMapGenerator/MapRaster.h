@@ -0,0 +1,73 @@
+#ifndef MAP_RASTER_H
+#define MAP_RASTER_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "MapPalette.h"
+#include "Math/Vector2.h"
+
+// Forward Declaration
+class Map;
+class ThreadPool;
+
+// CPU rasterizer that renders a map into an RGBA image, without a window or a graphics context.
+// Every cell and river edge becomes a convex polygon in pixel space, the polygons are binned
+// into square tiles and every tile fills its polygons in order with scanlines sampled at pixel centers,
+// so that adjacent cells share their edges without gaps or overlaps and tiles render independently.
+// The buffers are kept from one render to the next.
+class MapRaster
+{
+public:
+	// Side of the tiles rendered as separate tasks, in pixels
+	static const unsigned int TILE_SIZE = 64;
+
+	MapRaster();
+
+	~MapRaster() = default;
+
+	MapRaster(const MapRaster& raster) = delete;
+	MapRaster(MapRaster&& raster) = delete;
+
+	MapRaster& operator=(const MapRaster& raster) = delete;
+	MapRaster& operator=(MapRaster&& raster) = delete;
+
+	// Renders the cells in the colors of view and the rivers on top, the map is scaled to width x height.
+	// Tiles are spread on threadPool, or rendered on the calling thread if it is nullptr.
+	void Render(const Map& map, MapView view, unsigned int width, unsigned int height, ThreadPool* threadPool = nullptr);
+
+	unsigned int GetWidth() const;
+	unsigned int GetHeight() const;
+	// Four bytes per pixel, RGBA, rows from the top
+	const std::vector<uint8_t>& GetPixels() const;
+
+	// Binary PPM (P6), the alpha channel is dropped
+	bool WritePPM(const std::string& path) const;
+	// 8-bit RGBA PNG with stored (uncompressed) deflate blocks, which needs no compression library
+	bool WritePNG(const std::string& path) const;
+
+private:
+	void AddShape(const Vector2* points, unsigned int count, MapColor color);
+	void BinShapes();
+	void RenderTile(unsigned int tile);
+	void FillPolygon(unsigned int shape, unsigned int minX, unsigned int minY, unsigned int maxX, unsigned int maxY);
+
+	unsigned int m_width;
+	unsigned int m_height;
+	std::vector<uint8_t> m_pixels;
+
+	// Points of shape s are m_shapePoints[m_shapeOffsets[s]] ... m_shapePoints[m_shapeOffsets[s + 1] - 1], in pixels
+	std::vector<unsigned int> m_shapeOffsets;
+	std::vector<Vector2> m_shapePoints;
+	std::vector<MapColor> m_shapeColors;
+
+	// Shapes overlapping tile t, in drawing order, are m_tileShapes[m_tileOffsets[t]] ... m_tileShapes[m_tileOffsets[t + 1] - 1]
+	unsigned int m_tileColumns;
+	unsigned int m_tileRows;
+	std::vector<unsigned int> m_tileOffsets;
+	std::vector<unsigned int> m_tileShapes;
+	std::vector<unsigned int> m_shapeTiles;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef MAP_WORKSPACE_H
+#define MAP_WORKSPACE_H
+
+#include <vector>
+#include <memory>
+
+#include "DecayPropagation.h"
+#include "DistanceField.h"
+#include "RankTransform.h"
+
+// Forward Declaration
+namespace noise
+{
+	namespace module
+	{
+		class Perlin;
+	}
+}
+
+// Noise module and scratch buffers used while generating a map.
+// A workspace can be handed from one map to the next, so that repeated generation
+// reuses the same allocations instead of growing new ones for every map.
+struct MapWorkspace
+{
+	MapWorkspace();
+
+	~MapWorkspace();
+
+	MapWorkspace(const MapWorkspace& workspace) = delete;
+	MapWorkspace(MapWorkspace&& workspace) = delete;
+
+	MapWorkspace& operator=(const MapWorkspace& workspace) = delete;
+	MapWorkspace& operator=(MapWorkspace&& workspace) = delete;
+
+	std::unique_ptr<noise::module::Perlin> m_noise;
+
+	// FIFO of the flood fills, consumed by index instead of popped
+	std::vector<unsigned int> m_queue;
+	// Distance to the border of the corner elevations
+	DistanceField m_distanceField;
+	// Spread of the corner moisture from fresh water and from the ocean
+	DecayPropagation m_moisturePropagation;
+	// Land corners ranked by the redistribution stages
+	std::vector<unsigned int> m_locations;
+	// Sort buffers of the rank transform
+	std::vector<RankEntry> m_rankEntries;
+	std::vector<RankEntry> m_rankScratch;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <vector>
+
+#include "Math/Vector2.h"
+
+// Forward Declaration
+struct Center;
+struct Corner;
+struct Edge;
+
+// Compressed sparse row (CSR) adjacency list.
+// The neighbours of element i are m_indices[m_offsets[i]] ... m_indices[m_offsets[i + 1] - 1].
+struct Adjacency
+{
+	Adjacency() = default;
+
+	~Adjacency() = default;
+
+	Adjacency(const Adjacency& adjacency) = default;
+	Adjacency(Adjacency&& adjacency) = default;
+
+	Adjacency& operator=(const Adjacency& adjacency) = default;
+	Adjacency& operator=(Adjacency&& adjacency) = default;
+
+	const unsigned int* Begin(unsigned int i) const { return m_indices.data() + m_offsets[i]; }
+	const unsigned int* End(unsigned int i) const { return m_indices.data() + m_offsets[i + 1]; }
+	unsigned int Size(unsigned int i) const { return m_offsets[i + 1] - m_offsets[i]; }
+
+	void Clear();
+
+	std::vector<unsigned int> m_offsets;
+	std::vector<unsigned int> m_indices;
+};
+
+// Index-based copy of the Center/Corner/Edge graph.
+// Every element is addressed by its m_index, positions and adjacency live in contiguous arrays
+// so that graph traversals walk linear memory instead of chasing node pointers.
+struct Mesh
+{
+	static const unsigned int INVALID_INDEX = 0xFFFFFFFF;
+
+	Mesh() = default;
+
+	~Mesh() = default;
+
+	Mesh(const Mesh& mesh) = default;
+	Mesh(Mesh&& mesh) = default;
+
+	Mesh& operator=(const Mesh& mesh) = default;
+	Mesh& operator=(Mesh&& mesh) = default;
+
+	void Build(const std::vector<Center*>& centers, const std::vector<Corner*>& corners, const std::vector<Edge*>& edges);
+	void Clear();
+
+	unsigned int GetCenterCount() const { return static_cast<unsigned int>(m_centerPositions.size()); }
+	unsigned int GetCornerCount() const { return static_cast<unsigned int>(m_cornerPositions.size()); }
+	unsigned int GetEdgeCount() const { return static_cast<unsigned int>(m_edgeCenters.size() / 2); }
+
+	std::vector<Vector2> m_centerPositions;
+	std::vector<Vector2> m_cornerPositions;
+
+	Adjacency m_centerCenters;
+	Adjacency m_centerCorners;
+	Adjacency m_centerEdges;
+
+	Adjacency m_cornerCorners;
+	Adjacency m_cornerCenters;
+	Adjacency m_cornerEdges;
+
+	// Two entries per edge: (d0, d1) and (v0, v1), INVALID_INDEX if missing
+	std::vector<unsigned int> m_edgeCenters;
+	std::vector<unsigned int> m_edgeCorners;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,115 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <list>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+#include "Attributes.h"
+#include "Mesh.h"
+
+// Forward Declaration
+class ThreadPool;
+namespace noise
+{
+	namespace module
+	{
+		class Perlin;
+	}
+}
+
+// One square tile of a world, in world coordinates.
+// The mesh holds the centers whose site lies in the tile, with all their corners and edges;
+// neighbours in other tiles are Mesh::INVALID_INDEX, as are downslopes leaving the tile.
+struct WorldTile
+{
+	int m_x;
+	int m_y;
+
+	Mesh m_mesh;
+	MapAttributes m_attributes;
+
+	// World-wide ids of the centers and corners, equal for the same element in every tile
+	std::vector<uint64_t> m_centerIds;
+	std::vector<uint64_t> m_cornerIds;
+};
+
+// Unbounded map generated tile by tile, so that a world never has to fit in memory at once.
+// Sites are a jittered grid with one site per cell of pointSpread, placed by a hash of the cell,
+// and every attribute is computed from world-coordinate noise, so that a tile only depends on
+// its own cells and a halo of cells around them. A tile triangulates its cells and the halo and
+// keeps the owned part: corners shared by two tiles get the same position and attributes in both.
+// Lakes need an unbounded flood fill and are not generated, every water polygon is ocean, and rivers
+// are traced for a bounded number of steps, which is what bounds the halo.
+class World
+{
+public:
+	// Receives every generated tile, which is freed once the call returns.
+	// Called from the pool threads, one call at a time.
+	typedef std::function<void(const WorldTile& tile)> Consumer;
+
+	// A tile triangulates (tileCells + 2 * GetHaloCells())^2 sites to keep tileCells^2 of them, and the halo
+	// is 55 cells whatever tileCells is: 16-cell tiles do about 62 times the work of the sites they keep,
+	// 64-cell tiles about 7 times and 256-cell tiles about 2 times. Prefer tiles of 128 cells or more.
+	World(unsigned int tileCells, double pointSpread, std::string seed);
+
+	~World();
+
+	World(const World& world) = delete;
+	World(World&& world) = delete;
+
+	World& operator=(const World& world) = delete;
+	World& operator=(World&& world) = delete;
+
+	// Tile (x, y) from the cache, generated on a miss; the least recently used tile is evicted
+	// once the cache is full. Not thread-safe.
+	std::shared_ptr<const WorldTile> GetTile(int x, int y);
+	// Generates tile (x, y) without touching the cache, safe to call from several threads
+	std::unique_ptr<WorldTile> GenerateTile(int x, int y) const;
+
+	// Generates the tiles of [minX, maxX) x [minY, maxY) and hands each one to consumer.
+	// Tiles are spread on threadPool, or generated on the calling thread if it is nullptr.
+	void Stream(int minX, int minY, int maxX, int maxY, const Consumer& consumer, ThreadPool* threadPool = nullptr);
+
+	// Writes a tile in the MapFile binary format
+	static bool SaveTile(const WorldTile& tile, const std::string& path);
+
+	// Number of tiles kept by GetTile, 0 disables the cache
+	size_t GetCacheCapacity() const;
+	void SetCacheCapacity(size_t capacity);
+
+	unsigned int GetTileCells() const;
+	double GetPointSpread() const;
+	// Side of a tile in world units
+	double GetTileSize() const;
+	// Cells generated around a tile so that its owned part matches its neighbours
+	unsigned int GetHaloCells() const;
+
+private:
+	typedef std::pair<uint64_t, std::shared_ptr<const WorldTile>> CacheEntry;
+
+	void Evict();
+
+	unsigned int m_tileCells;
+	unsigned int m_haloCells;
+	double m_pointSpread;
+	std::string m_seed;
+	uint64_t m_pointSeed;
+	uint64_t m_riverSeed;
+	std::unique_ptr<noise::module::Perlin> m_landNoise;
+	std::unique_ptr<noise::module::Perlin> m_moistureNoise;
+
+	// Most recently used first
+	size_t m_cacheCapacity;
+	std::list<CacheEntry> m_cache;
+	std::unordered_map<uint64_t, std::list<CacheEntry>::iterator> m_cacheEntries;
+
+	std::mutex m_consumerMutex;
+};
+
+#endif
\ No newline at end of file
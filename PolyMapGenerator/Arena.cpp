@@ -0,0 +1,68 @@
+#include "Arena.h"
+
+#include <algorithm>
+
+namespace
+{
+	const size_t MAX_BLOCK_SIZE = 16 * 1024 * 1024;
+}
+
+Arena::Arena(size_t blockSize) : m_currentBlock(0), m_offset(0), m_nextBlockSize(blockSize)
+{
+
+}
+
+Arena::~Arena()
+{
+	for (auto& block : m_blocks)
+	{
+		::operator delete(block.m_data);
+	}
+}
+
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+	// Walk the blocks left over from before the last Reset, then grow
+	while (m_currentBlock < m_blocks.size())
+	{
+		Block& block = m_blocks[m_currentBlock];
+		size_t offset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+		if (offset + size <= block.m_size)
+		{
+			m_offset = offset + size;
+			return block.m_data + offset;
+		}
+
+		m_currentBlock++;
+		m_offset = 0;
+	}
+
+	// Blocks come from operator new, which is aligned for every fundamental type
+	size_t blockSize = std::max(m_nextBlockSize, size);
+	m_nextBlockSize = std::min(m_nextBlockSize * 2, MAX_BLOCK_SIZE);
+
+	m_blocks.push_back(Block{ static_cast<unsigned char*>(::operator new(blockSize)), blockSize });
+	m_currentBlock = m_blocks.size() - 1;
+	m_offset = size;
+
+	return m_blocks.back().m_data;
+}
+
+void Arena::Reset()
+{
+	m_currentBlock = 0;
+	m_offset = 0;
+}
+
+size_t Arena::GetCapacity() const
+{
+	size_t capacity = 0;
+
+	for (auto& block : m_blocks)
+	{
+		capacity += block.m_size;
+	}
+
+	return capacity;
+}
\ No newline at end of file
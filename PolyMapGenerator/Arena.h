@@ -0,0 +1,106 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+// Bump allocator that owns every block it hands out.
+// Allocations are never freed one by one: Reset() rewinds the arena and keeps its blocks for reuse,
+// the destructor releases them. Objects placed in an arena must not own memory outside of it,
+// since their destructors are never run.
+class Arena
+{
+public:
+	explicit Arena(size_t blockSize = 64 * 1024);
+
+	~Arena();
+
+	Arena(const Arena& arena) = delete;
+	Arena(Arena&& arena) = delete;
+
+	Arena& operator=(const Arena& arena) = delete;
+	Arena& operator=(Arena&& arena) = delete;
+
+	void* Allocate(size_t size, size_t alignment);
+	void Reset();
+
+	template <typename T, typename... Args>
+	T* New(Args&&... args)
+	{
+		return new (Allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	// Bytes reserved from the system, used or not
+	size_t GetCapacity() const;
+
+private:
+	struct Block
+	{
+		unsigned char* m_data;
+		size_t m_size;
+	};
+
+	std::vector<Block> m_blocks;
+	size_t m_currentBlock;
+	size_t m_offset;
+	size_t m_nextBlockSize;
+};
+
+// Standard allocator on top of an Arena, deallocation is a no-op.
+// Without an arena it falls back to the global heap, so containers of arena-less nodes still work.
+template <typename T>
+class ArenaAllocator
+{
+public:
+	typedef T value_type;
+
+	template <typename U>
+	struct rebind
+	{
+		typedef ArenaAllocator<U> other;
+	};
+
+	ArenaAllocator() : m_arena(nullptr) { }
+	explicit ArenaAllocator(Arena* arena) : m_arena(arena) { }
+	template <typename U>
+	ArenaAllocator(const ArenaAllocator<U>& allocator) : m_arena(allocator.m_arena) { }
+
+	T* allocate(size_t n)
+	{
+		if (m_arena == nullptr)
+		{
+			return static_cast<T*>(::operator new(n * sizeof(T)));
+		}
+
+		return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+	}
+
+	void deallocate(T* p, size_t)
+	{
+		if (m_arena == nullptr)
+		{
+			::operator delete(p);
+		}
+	}
+
+	Arena* m_arena;
+};
+
+template <typename T, typename U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.m_arena == b.m_arena;
+}
+
+template <typename T, typename U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+	return a.m_arena != b.m_arena;
+}
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif
\ No newline at end of file
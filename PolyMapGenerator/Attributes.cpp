@@ -0,0 +1,105 @@
+#include "Attributes.h"
+#include "Mesh.h"
+
+#include <algorithm>
+
+void BitSet::Resize(size_t size)
+{
+	m_size = size;
+	m_words.assign((size + 63) / 64, 0);
+}
+
+void BitSet::Clear()
+{
+	std::fill(m_words.begin(), m_words.end(), 0);
+}
+
+size_t BitSet::Count() const
+{
+	size_t count = 0;
+
+	for (auto word : m_words)
+	{
+		while (word != 0)
+		{
+			word &= word - 1;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+void CenterAttributes::Resize(size_t count)
+{
+	m_elevation.assign(count, 0.0);
+	m_moisture.assign(count, 0.0);
+	m_biome.assign(count, BiomeType::None);
+
+	m_water.Resize(count);
+	m_ocean.Resize(count);
+	m_coast.Resize(count);
+	m_border.Resize(count);
+}
+
+void CornerAttributes::Resize(size_t count)
+{
+	m_elevation.assign(count, 0.0);
+	m_moisture.assign(count, 0.0);
+	m_riverVolume.assign(count, 0.0);
+	m_downslope.assign(count, Mesh::INVALID_INDEX);
+	m_downslopeEdge.assign(count, Mesh::INVALID_INDEX);
+
+	m_water.Resize(count);
+	m_ocean.Resize(count);
+	m_coast.Resize(count);
+	m_border.Resize(count);
+}
+
+void EdgeAttributes::Resize(size_t count)
+{
+	m_riverVolume.assign(count, 0.0);
+}
+
+void MapAttributes::Resize(const Mesh& mesh)
+{
+	m_centers.Resize(mesh.GetCenterCount());
+	m_corners.Resize(mesh.GetCornerCount());
+	m_edges.Resize(mesh.GetEdgeCount());
+}
+
+void MapAttributes::Apply(const std::vector<Center*>& centers, const std::vector<Corner*>& corners, const std::vector<Edge*>& edges) const
+{
+	for (auto center : centers)
+	{
+		unsigned int i = center->m_index;
+
+		center->m_elevation = m_centers.m_elevation[i];
+		center->m_moisture = m_centers.m_moisture[i];
+		center->m_biome = m_centers.m_biome[i];
+		center->m_water = m_centers.m_water.Test(i);
+		center->m_ocean = m_centers.m_ocean.Test(i);
+		center->m_coast = m_centers.m_coast.Test(i);
+		center->m_border = m_centers.m_border.Test(i);
+	}
+
+	for (auto corner : corners)
+	{
+		unsigned int i = corner->m_index;
+		unsigned int downslope = m_corners.m_downslope[i];
+
+		corner->m_elevation = m_corners.m_elevation[i];
+		corner->m_moisture = m_corners.m_moisture[i];
+		corner->m_riverVolume = m_corners.m_riverVolume[i];
+		corner->m_downslope = downslope != Mesh::INVALID_INDEX ? corners[downslope] : nullptr;
+		corner->m_water = m_corners.m_water.Test(i);
+		corner->m_ocean = m_corners.m_ocean.Test(i);
+		corner->m_coast = m_corners.m_coast.Test(i);
+		corner->m_border = m_corners.m_border.Test(i);
+	}
+
+	for (auto edge : edges)
+	{
+		edge->m_riverVolume = m_edges.m_riverVolume[edge->m_index];
+	}
+}
\ No newline at end of file
@@ -0,0 +1,119 @@
+#ifndef ATTRIBUTES_H
+#define ATTRIBUTES_H
+
+#include <vector>
+#include <cstdint>
+
+#include "Structure.h"
+
+// Forward Declaration
+struct Mesh;
+
+// Fixed-size bit array for per-element boolean flags, packed 64 flags per word
+class BitSet
+{
+public:
+	BitSet() : m_size(0) { }
+	explicit BitSet(size_t size) : m_words((size + 63) / 64, 0), m_size(size) { }
+
+	~BitSet() = default;
+
+	BitSet(const BitSet& bs) = default;
+	BitSet(BitSet&& bs) = default;
+
+	BitSet& operator=(const BitSet& bs) = default;
+	BitSet& operator=(BitSet&& bs) = default;
+
+	bool Test(size_t i) const
+	{
+		return (m_words[i >> 6] >> (i & 63)) & 1;
+	}
+
+	void Set(size_t i, bool value = true)
+	{
+		uint64_t mask = static_cast<uint64_t>(1) << (i & 63);
+
+		if (value)
+		{
+			m_words[i >> 6] |= mask;
+		}
+		else
+		{
+			m_words[i >> 6] &= ~mask;
+		}
+	}
+
+	void Reset(size_t i)
+	{
+		Set(i, false);
+	}
+
+	void Resize(size_t size);
+	void Clear();
+	size_t Count() const;
+
+	size_t Size() const { return m_size; }
+	size_t GetWordCount() const { return m_words.size(); }
+	const uint64_t* GetWords() const { return m_words.data(); }
+	uint64_t* GetWords() { return m_words.data(); }
+
+private:
+	std::vector<uint64_t> m_words;
+	size_t m_size;
+};
+
+// Per-attribute channels of the centers, indexed by Center::m_index
+struct CenterAttributes
+{
+	void Resize(size_t count);
+
+	std::vector<double> m_elevation;
+	std::vector<double> m_moisture;
+	std::vector<BiomeType> m_biome;
+
+	BitSet m_water;
+	BitSet m_ocean;
+	BitSet m_coast;
+	BitSet m_border;
+};
+
+// Per-attribute channels of the corners, indexed by Corner::m_index
+struct CornerAttributes
+{
+	void Resize(size_t count);
+
+	std::vector<double> m_elevation;
+	std::vector<double> m_moisture;
+	std::vector<double> m_riverVolume;
+	std::vector<unsigned int> m_downslope;
+	// Edge towards the downslope corner, Mesh::INVALID_INDEX if the corner is its own downslope
+	std::vector<unsigned int> m_downslopeEdge;
+
+	BitSet m_water;
+	BitSet m_ocean;
+	BitSet m_coast;
+	BitSet m_border;
+};
+
+// Per-attribute channels of the edges, indexed by Edge::m_index
+struct EdgeAttributes
+{
+	void Resize(size_t count);
+
+	std::vector<double> m_riverVolume;
+};
+
+// Structure-of-arrays storage of every generated attribute of a map.
+// Generation passes stream single channels from here, the Center/Corner/Edge
+// objects receive a copy of the final values through Apply().
+struct MapAttributes
+{
+	void Resize(const Mesh& mesh);
+	void Apply(const std::vector<Center*>& centers, const std::vector<Corner*>& corners, const std::vector<Edge*>& edges) const;
+
+	CenterAttributes m_centers;
+	CornerAttributes m_corners;
+	EdgeAttributes m_edges;
+};
+
+#endif
\ No newline at end of file
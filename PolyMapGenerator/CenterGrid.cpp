@@ -0,0 +1,263 @@
+#include <cmath>
+#include <limits>
+#include <cassert>
+#include <algorithm>
+
+#include "CenterGrid.h"
+#include "Mesh.h"
+
+namespace
+{
+	// Batches at least this large are bucketed by grid row before the lookups
+	const size_t BINNING_THRESHOLD = 4096;
+
+	// Buffers of the batch being located, reused by the next batch of the thread
+	thread_local std::vector<unsigned int> t_queryCells;
+	thread_local std::vector<unsigned int> t_rowOffsets;
+	thread_local std::vector<unsigned int> t_rowQueries;
+}
+
+CenterGrid::CenterGrid() :
+	m_width(0.0), m_height(0.0), m_cellSize(1.0), m_inverseCellSize(1.0), m_columns(0), m_rows(0)
+{
+
+}
+
+void CenterGrid::Build(const Mesh& mesh, double width, double height, double cellSize)
+{
+	Clear();
+
+	m_width = width;
+	m_height = height;
+	m_cellSize = cellSize > 0.0 ? cellSize : 1.0;
+	m_inverseCellSize = 1.0 / m_cellSize;
+	m_columns = std::max(static_cast<unsigned int>(ceil(width * m_inverseCellSize)), 1u);
+	m_rows = std::max(static_cast<unsigned int>(ceil(height * m_inverseCellSize)), 1u);
+
+	unsigned int centerCount = mesh.GetCenterCount();
+	auto toColumn = [this](double x)
+	{
+		return std::min(static_cast<unsigned int>(std::max(x, 0.0) * m_inverseCellSize), m_columns - 1);
+	};
+	auto toRow = [this](double y)
+	{
+		return std::min(static_cast<unsigned int>(std::max(y, 0.0) * m_inverseCellSize), m_rows - 1);
+	};
+
+	// Cell range covered by the bounding box of every polygon, empty for polygons outside the grid
+	std::vector<unsigned int> ranges(centerCount * 4, 0);
+
+	for (unsigned int center = 0; center < centerCount; ++center)
+	{
+		const unsigned int* begin = mesh.m_centerCorners.Begin(center);
+		const unsigned int* end = mesh.m_centerCorners.End(center);
+
+		if (begin == end)
+		{
+			continue;
+		}
+
+		Vector2 minPoint = mesh.m_cornerPositions[*begin];
+		Vector2 maxPoint = minPoint;
+
+		for (const unsigned int* corner = begin + 1; corner != end; ++corner)
+		{
+			const Vector2& position = mesh.m_cornerPositions[*corner];
+
+			minPoint.x = std::min(minPoint.x, position.x);
+			minPoint.y = std::min(minPoint.y, position.y);
+			maxPoint.x = std::max(maxPoint.x, position.x);
+			maxPoint.y = std::max(maxPoint.y, position.y);
+		}
+
+		if (maxPoint.x < 0.0 || maxPoint.y < 0.0 || minPoint.x > width || minPoint.y > height)
+		{
+			continue;
+		}
+
+		unsigned int* range = &ranges[center * 4];
+		range[0] = toColumn(minPoint.x);
+		range[1] = toRow(minPoint.y);
+		range[2] = toColumn(maxPoint.x) + 1;
+		range[3] = toRow(maxPoint.y) + 1;
+	}
+
+	// Counting pass, then a fill pass in center order so that ties resolve to the lowest index
+	m_cellOffsets.assign(m_columns * m_rows + 1, 0);
+
+	for (unsigned int center = 0; center < centerCount; ++center)
+	{
+		const unsigned int* range = &ranges[center * 4];
+
+		for (unsigned int row = range[1]; row < range[3]; ++row)
+		{
+			for (unsigned int column = range[0]; column < range[2]; ++column)
+			{
+				m_cellOffsets[row * m_columns + column + 1]++;
+			}
+		}
+	}
+
+	for (size_t cell = 1; cell < m_cellOffsets.size(); ++cell)
+	{
+		m_cellOffsets[cell] += m_cellOffsets[cell - 1];
+	}
+
+	std::vector<unsigned int> cursors(m_cellOffsets.begin(), m_cellOffsets.end() - 1);
+	m_cellCenters.resize(m_cellOffsets.back());
+	m_cellPositions.resize(m_cellOffsets.back());
+
+	for (unsigned int center = 0; center < centerCount; ++center)
+	{
+		const unsigned int* range = &ranges[center * 4];
+
+		for (unsigned int row = range[1]; row < range[3]; ++row)
+		{
+			for (unsigned int column = range[0]; column < range[2]; ++column)
+			{
+				unsigned int slot = cursors[row * m_columns + column]++;
+				m_cellCenters[slot] = center;
+				m_cellPositions[slot] = mesh.m_centerPositions[center];
+			}
+		}
+	}
+}
+
+void CenterGrid::Clear()
+{
+	m_columns = 0;
+	m_rows = 0;
+	m_cellOffsets.clear();
+	m_cellCenters.clear();
+	m_cellPositions.clear();
+}
+
+unsigned int CenterGrid::FindCenter(Vector2 position) const
+{
+	unsigned int cell = GetCell(position);
+
+	return cell < m_columns * m_rows ? FindInCell(cell, position) : Mesh::INVALID_INDEX;
+}
+
+void CenterGrid::FindCenters(Span<const Vector2> positions, Span<unsigned int> centers) const
+{
+	assert(centers.Size() >= positions.Size());
+	assert(positions.Size() <= 0xFFFFFFFF);
+
+	unsigned int cellCount = m_columns * m_rows;
+
+	if (positions.Size() < BINNING_THRESHOLD)
+	{
+		for (size_t i = 0; i < positions.Size(); ++i)
+		{
+			unsigned int cell = GetCell(positions[i]);
+			centers[i] = cell < cellCount ? FindInCell(cell, positions[i]) : Mesh::INVALID_INDEX;
+		}
+
+		return;
+	}
+
+	// Counting sort of the queries by grid row, so that the cells are read close to memory order
+	std::vector<unsigned int>& queryCells = t_queryCells;
+	std::vector<unsigned int>& rowOffsets = t_rowOffsets;
+	std::vector<unsigned int>& rowQueries = t_rowQueries;
+
+	queryCells.resize(positions.Size());
+	rowOffsets.assign(m_rows + 1, 0);
+
+	for (size_t i = 0; i < positions.Size(); ++i)
+	{
+		unsigned int cell = GetCell(positions[i]);
+		queryCells[i] = cell;
+
+		if (cell < cellCount)
+		{
+			rowOffsets[cell / m_columns + 1]++;
+		}
+		else
+		{
+			centers[i] = Mesh::INVALID_INDEX;
+		}
+	}
+
+	for (unsigned int row = 1; row <= m_rows; ++row)
+	{
+		rowOffsets[row] += rowOffsets[row - 1];
+	}
+
+	rowQueries.resize(rowOffsets[m_rows]);
+
+	for (size_t i = 0; i < positions.Size(); ++i)
+	{
+		if (queryCells[i] < cellCount)
+		{
+			rowQueries[rowOffsets[queryCells[i] / m_columns]++] = static_cast<unsigned int>(i);
+		}
+	}
+
+	for (auto i : rowQueries)
+	{
+		centers[i] = FindInCell(queryCells[i], positions[i]);
+	}
+}
+
+unsigned int CenterGrid::GetColumnCount() const
+{
+	return m_columns;
+}
+
+unsigned int CenterGrid::GetRowCount() const
+{
+	return m_rows;
+}
+
+double CenterGrid::GetCellSize() const
+{
+	return m_cellSize;
+}
+
+unsigned int CenterGrid::GetCell(Vector2 position) const
+{
+	// Written so that NaN coordinates also fall outside
+	if (!(position.x >= 0.0 && position.y >= 0.0 && position.x <= m_width && position.y <= m_height) || m_columns == 0)
+	{
+		return m_columns * m_rows;
+	}
+
+	unsigned int column = std::min(static_cast<unsigned int>(position.x * m_inverseCellSize), m_columns - 1);
+	unsigned int row = std::min(static_cast<unsigned int>(position.y * m_inverseCellSize), m_rows - 1);
+
+	return row * m_columns + column;
+}
+
+unsigned int CenterGrid::FindInCell(unsigned int cell, Vector2 position) const
+{
+	unsigned int begin = m_cellOffsets[cell];
+	unsigned int end = m_cellOffsets[cell + 1];
+
+	if (begin == end)
+	{
+		return Mesh::INVALID_INDEX;
+	}
+
+	// Squared distances only, and the center index is only read for the winner,
+	// which leaves the compiler a loop body it can turn into selects
+	const Vector2* positions = m_cellPositions.data();
+	unsigned int nearest = begin;
+	double minDistance = std::numeric_limits<double>::infinity();
+
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		double dx = positions[i].x - position.x;
+		double dy = positions[i].y - position.y;
+		double distance = dx * dx + dy * dy;
+
+		if (distance < minDistance)
+		{
+			minDistance = distance;
+			nearest = i;
+		}
+	}
+
+	return m_cellCenters[nearest];
+}
\ No newline at end of file
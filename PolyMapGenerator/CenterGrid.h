@@ -0,0 +1,62 @@
+#ifndef CENTER_GRID_H
+#define CENTER_GRID_H
+
+#include <vector>
+
+#include "Span.h"
+#include "Math/Vector2.h"
+
+// Forward Declaration
+struct Mesh;
+
+// Uniform grid for point location over the centers of a map.
+// Every cell lists the centers whose polygon bounding box overlaps it, together with their positions,
+// so the center closest to a point is among the few candidates of the cell holding the point
+// and a lookup is one cell computation and a short linear scan, without allocating.
+class CenterGrid
+{
+public:
+	CenterGrid();
+
+	~CenterGrid() = default;
+
+	CenterGrid(const CenterGrid& grid) = delete;
+	CenterGrid(CenterGrid&& grid) = delete;
+
+	CenterGrid& operator=(const CenterGrid& grid) = delete;
+	CenterGrid& operator=(CenterGrid&& grid) = delete;
+
+	// Covers [0, width] x [0, height] with square cells of about cellSize
+	void Build(const Mesh& mesh, double width, double height, double cellSize);
+	void Clear();
+
+	// Index of the center closest to position, Mesh::INVALID_INDEX outside the grid
+	unsigned int FindCenter(Vector2 position) const;
+	// Same as FindCenter for every position, centers must be as long as positions.
+	// Large batches are bucketed by grid row first, so that the cells are read close to memory order.
+	void FindCenters(Span<const Vector2> positions, Span<unsigned int> centers) const;
+
+	unsigned int GetColumnCount() const;
+	unsigned int GetRowCount() const;
+	double GetCellSize() const;
+
+private:
+	// Cell holding position, or an index past the last cell outside the grid
+	unsigned int GetCell(Vector2 position) const;
+	unsigned int FindInCell(unsigned int cell, Vector2 position) const;
+
+	double m_width;
+	double m_height;
+	double m_cellSize;
+	double m_inverseCellSize;
+	unsigned int m_columns;
+	unsigned int m_rows;
+
+	// Candidates of cell c are m_cellCenters[m_cellOffsets[c]] ... m_cellCenters[m_cellOffsets[c + 1] - 1],
+	// their positions are copied next to them so that a lookup reads one contiguous range
+	std::vector<unsigned int> m_cellOffsets;
+	std::vector<unsigned int> m_cellCenters;
+	std::vector<Vector2> m_cellPositions;
+};
+
+#endif
\ No newline at end of file
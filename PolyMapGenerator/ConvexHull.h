@@ -13,10 +13,12 @@ namespace ConvexHull
 		return (A.x - O.x) * (B.y - O.y) - (A.y - O.y) * (B.x - O.x);
 	}
 
-	inline void CalculateConvexHull(std::vector<Corner*>& P)
+	// Works on any vector of corners, whatever its allocator
+	template <typename Container>
+	inline void CalculateConvexHull(Container& P)
 	{
 		int n = P.size(), k = 0;
-		std::vector<Corner*> H(2 * n);
+		Container H(2 * n, nullptr, P.get_allocator());
 
 		// Sort points lexicographically
 		sort(P.begin(), P.end(), [](Corner* c1, Corner* c2)
@@ -0,0 +1,197 @@
+#include <cstring>
+#include <algorithm>
+
+#include "DecayPropagation.h"
+
+namespace
+{
+	// Smallest frontier block worth a task of its own
+	const unsigned int MIN_BLOCK_SIZE = 1024;
+	const unsigned int GRAIN_SIZE = 4096;
+
+	uint64_t ToBits(double value)
+	{
+		uint64_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+
+		return bits;
+	}
+
+	double ToDouble(uint64_t bits)
+	{
+		double value;
+		memcpy(&value, &bits, sizeof(value));
+
+		return value;
+	}
+}
+
+DecayPropagation::DecayPropagation() : m_capacity(0), m_pushCount(0)
+{
+
+}
+
+void DecayPropagation::Propagate(const Adjacency& adjacency, std::vector<double>& values, const std::vector<unsigned int>& sources, double decay, ThreadPool& pool)
+{
+	// Without other threads, a FIFO straight on the values reaches the same fixed point without the atomic copy
+	if (pool.GetThreadCount() == 1)
+	{
+		PropagateSerial(adjacency, values, sources, decay);
+		return;
+	}
+
+	unsigned int vertexCount = static_cast<unsigned int>(values.size());
+	Reserve(vertexCount);
+
+	pool.ParallelFor(vertexCount, GRAIN_SIZE, [this, &values](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; ++v)
+		{
+			m_values[v].store(ToBits(values[v]), std::memory_order_relaxed);
+			m_queued[v].store(false, std::memory_order_relaxed);
+		}
+	});
+
+	m_frontier = sources;
+	m_pushCount = static_cast<unsigned int>(sources.size());
+
+	while (!m_frontier.empty())
+	{
+		unsigned int frontierSize = static_cast<unsigned int>(m_frontier.size());
+		unsigned int blockCount = std::max(1u, std::min(pool.GetThreadCount() * 4, frontierSize / MIN_BLOCK_SIZE));
+		unsigned int blockSize = (frontierSize + blockCount - 1) / blockCount;
+
+		if (m_blockFrontiers.size() < blockCount)
+		{
+			m_blockFrontiers.resize(blockCount);
+		}
+
+		if (blockCount == 1)
+		{
+			m_blockFrontiers[0].clear();
+			RelaxSerial(adjacency, decay, 0, frontierSize, m_blockFrontiers[0]);
+		}
+		else
+		{
+			pool.ParallelFor(blockCount, 1, [this, &adjacency, decay, frontierSize, blockSize](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int b = begin; b < end; ++b)
+				{
+					m_blockFrontiers[b].clear();
+					RelaxParallel(adjacency, decay, b * blockSize, std::min(frontierSize, (b + 1) * blockSize), m_blockFrontiers[b]);
+				}
+			});
+		}
+
+		m_frontier.clear();
+
+		for (unsigned int b = 0; b < blockCount; ++b)
+		{
+			m_frontier.insert(m_frontier.end(), m_blockFrontiers[b].begin(), m_blockFrontiers[b].end());
+		}
+
+		// Cleared before the level runs, so that a vertex raised again while it is relaxed is queued once more
+		for (unsigned int v : m_frontier)
+		{
+			m_queued[v].store(false, std::memory_order_relaxed);
+		}
+
+		m_pushCount += static_cast<unsigned int>(m_frontier.size());
+	}
+
+	pool.ParallelFor(vertexCount, GRAIN_SIZE, [this, &values](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int v = begin; v < end; ++v)
+		{
+			values[v] = ToDouble(m_values[v].load(std::memory_order_relaxed));
+		}
+	});
+}
+
+void DecayPropagation::PropagateSerial(const Adjacency& adjacency, std::vector<double>& values, const std::vector<unsigned int>& sources, double decay)
+{
+	// Consumed by index instead of popped
+	m_frontier = sources;
+
+	for (size_t head = 0; head < m_frontier.size(); ++head)
+	{
+		unsigned int v = m_frontier[head];
+		double newValue = values[v] * decay;
+
+		for (const unsigned int* n = adjacency.Begin(v); n != adjacency.End(v); ++n)
+		{
+			if (newValue > values[*n])
+			{
+				values[*n] = newValue;
+				m_frontier.push_back(*n);
+			}
+		}
+	}
+
+	m_pushCount = static_cast<unsigned int>(m_frontier.size());
+}
+
+void DecayPropagation::RelaxSerial(const Adjacency& adjacency, double decay, unsigned int begin, unsigned int end, std::vector<unsigned int>& next)
+{
+	// The only thread on the values, plain loads and stores do
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		unsigned int v = m_frontier[i];
+		// The latest value, a raise of this level is spread now rather than on the next one
+		uint64_t newValue = ToBits(ToDouble(m_values[v].load(std::memory_order_relaxed)) * decay);
+
+		for (const unsigned int* n = adjacency.Begin(v); n != adjacency.End(v); ++n)
+		{
+			if (newValue > m_values[*n].load(std::memory_order_relaxed))
+			{
+				m_values[*n].store(newValue, std::memory_order_relaxed);
+
+				if (!m_queued[*n].load(std::memory_order_relaxed))
+				{
+					m_queued[*n].store(true, std::memory_order_relaxed);
+					next.push_back(*n);
+				}
+			}
+		}
+	}
+}
+
+void DecayPropagation::RelaxParallel(const Adjacency& adjacency, double decay, unsigned int begin, unsigned int end, std::vector<unsigned int>& next)
+{
+	for (unsigned int i = begin; i < end; ++i)
+	{
+		unsigned int v = m_frontier[i];
+		uint64_t newValue = ToBits(ToDouble(m_values[v].load(std::memory_order_relaxed)) * decay);
+
+		for (const unsigned int* n = adjacency.Begin(v); n != adjacency.End(v); ++n)
+		{
+			uint64_t current = m_values[*n].load(std::memory_order_relaxed);
+			bool raised = false;
+
+			while (newValue > current && !raised)
+			{
+				raised = m_values[*n].compare_exchange_weak(current, newValue, std::memory_order_relaxed);
+			}
+
+			if (raised && !m_queued[*n].load(std::memory_order_relaxed) && !m_queued[*n].exchange(true, std::memory_order_relaxed))
+			{
+				next.push_back(*n);
+			}
+		}
+	}
+}
+
+unsigned int DecayPropagation::GetPushCount() const
+{
+	return m_pushCount;
+}
+
+void DecayPropagation::Reserve(unsigned int vertexCount)
+{
+	if (m_capacity < vertexCount)
+	{
+		m_values.reset(new std::atomic<uint64_t>[vertexCount]);
+		m_queued.reset(new std::atomic<bool>[vertexCount]);
+		m_capacity = vertexCount;
+	}
+}
\ No newline at end of file
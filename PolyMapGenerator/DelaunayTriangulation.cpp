@@ -1,5 +1,11 @@
 #include "DelaunayTriangulation.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <unordered_map>
+
 namespace DelaunayTriangulation
 {
 	const double sqrt3 = 1.732050808;
@@ -191,7 +197,571 @@ namespace DelaunayTriangulation
 		EdgeSet& m_edges;
 	};
 
+	class SweepHullBuilder
+	{
+	public:
+		explicit SweepHullBuilder(const std::vector<const Vertex*>& points) :
+			m_points(points), m_centerX(0.0), m_centerY(0.0), m_hashSize(0), m_hullStart(0), m_trianglesLen(0) { }
+
+		// Fills m_triangles with vertex indices (three per triangle), returns false if all points are collinear
+		bool Build()
+		{
+			const int n = static_cast<int>(m_points.size());
+
+			double minX = m_points[0]->GetX(), minY = m_points[0]->GetY();
+			double maxX = minX, maxY = minY;
+
+			for (int i = 1; i < n; ++i)
+			{
+				minX = std::min(minX, m_points[i]->GetX());
+				minY = std::min(minY, m_points[i]->GetY());
+				maxX = std::max(maxX, m_points[i]->GetX());
+				maxY = std::max(maxY, m_points[i]->GetY());
+			}
+
+			double cx = (minX + maxX) * 0.5;
+			double cy = (minY + maxY) * 0.5;
+
+			// Pick a seed point close to the center, its closest neighbour,
+			// and the third point forming the smallest circumcircle with them
+			int i0 = 0, i1 = -1, i2 = -1;
+			double minDist = std::numeric_limits<double>::infinity();
+
+			for (int i = 0; i < n; ++i)
+			{
+				double d = DistSquare(cx, cy, X(i), Y(i));
+				if (d < minDist)
+				{
+					i0 = i;
+					minDist = d;
+				}
+			}
+
+			minDist = std::numeric_limits<double>::infinity();
+
+			for (int i = 0; i < n; ++i)
+			{
+				if (i == i0)
+				{
+					continue;
+				}
+
+				double d = DistSquare(X(i0), Y(i0), X(i), Y(i));
+				if (d < minDist && d > 0)
+				{
+					i1 = i;
+					minDist = d;
+				}
+			}
+
+			if (i1 == -1)
+			{
+				return false;
+			}
+
+			double minRadius = std::numeric_limits<double>::infinity();
+
+			for (int i = 0; i < n; ++i)
+			{
+				if (i == i0 || i == i1)
+				{
+					continue;
+				}
+
+				double r = CircumRadius(X(i0), Y(i0), X(i1), Y(i1), X(i), Y(i));
+				if (r < minRadius)
+				{
+					i2 = i;
+					minRadius = r;
+				}
+			}
+
+			if (i2 == -1)
+			{
+				return false;
+			}
+
+			if (Orient(X(i0), Y(i0), X(i1), Y(i1), X(i2), Y(i2)) < 0)
+			{
+				std::swap(i1, i2);
+			}
+
+			CircumCenter(X(i0), Y(i0), X(i1), Y(i1), X(i2), Y(i2), m_centerX, m_centerY);
+
+			// Sort the points by distance from the seed triangle circumcenter
+			std::vector<double> dists(n);
+			std::vector<int> ids(n);
+
+			for (int i = 0; i < n; ++i)
+			{
+				ids[i] = i;
+				dists[i] = DistSquare(X(i), Y(i), m_centerX, m_centerY);
+			}
+
+			std::sort(ids.begin(), ids.end(), [&dists](int a, int b)
+			{
+				return dists[a] < dists[b] || (dists[a] == dists[b] && a < b);
+			});
+
+			int maxTriangles = std::max(2 * n - 5, 1);
+			m_triangles.assign(maxTriangles * 3, -1);
+			m_halfEdges.assign(maxTriangles * 3, -1);
+
+			m_hashSize = static_cast<int>(ceil(sqrt(static_cast<double>(n))));
+			m_hullHash.assign(m_hashSize, -1);
+			m_hullPrev.assign(n, -1);
+			m_hullNext.assign(n, -1);
+			m_hullTri.assign(n, -1);
+
+			m_hullStart = i0;
+			m_hullNext[i0] = m_hullPrev[i2] = i1;
+			m_hullNext[i1] = m_hullPrev[i0] = i2;
+			m_hullNext[i2] = m_hullPrev[i1] = i0;
+
+			m_hullTri[i0] = 0;
+			m_hullTri[i1] = 1;
+			m_hullTri[i2] = 2;
+
+			m_hullHash[HashKey(X(i0), Y(i0))] = i0;
+			m_hullHash[HashKey(X(i1), Y(i1))] = i1;
+			m_hullHash[HashKey(X(i2), Y(i2))] = i2;
+
+			m_trianglesLen = 0;
+			AddTriangle(i0, i1, i2, -1, -1, -1);
+
+			double xp = 0.0, yp = 0.0;
+
+			for (int k = 0; k < n; ++k)
+			{
+				const int i = ids[k];
+				const double x = X(i);
+				const double y = Y(i);
+
+				// Skip near-duplicate points
+				if (k > 0 && std::abs(x - xp) <= EPSILON && std::abs(y - yp) <= EPSILON)
+				{
+					continue;
+				}
+
+				xp = x;
+				yp = y;
+
+				// Skip seed triangle points
+				if (i == i0 || i == i1 || i == i2)
+				{
+					continue;
+				}
+
+				// Find a visible edge on the convex hull using the edge hash
+				int start = 0;
+				for (int j = 0, key = HashKey(x, y); j < m_hashSize; ++j)
+				{
+					start = m_hullHash[(key + j) % m_hashSize];
+					if (start != -1 && start != m_hullNext[start])
+					{
+						break;
+					}
+				}
+
+				start = m_hullPrev[start];
+				int e = start;
+				int q = m_hullNext[e];
+
+				while (Orient(x, y, X(e), Y(e), X(q), Y(q)) >= 0)
+				{
+					e = q;
+					if (e == start)
+					{
+						e = -1;
+						break;
+					}
+
+					q = m_hullNext[e];
+				}
+
+				// Likely a near-duplicate point
+				if (e == -1)
+				{
+					continue;
+				}
+
+				// Add the first triangle from the point and flip until it satisfies the Delaunay condition
+				int t = AddTriangle(e, i, m_hullNext[e], -1, -1, m_hullTri[e]);
+
+				m_hullTri[i] = Legalize(t + 2);
+				m_hullTri[e] = t;
+
+				// Walk forward through the hull, adding more triangles and flipping
+				int next = m_hullNext[e];
+				q = m_hullNext[next];
+
+				while (Orient(x, y, X(next), Y(next), X(q), Y(q)) < 0)
+				{
+					t = AddTriangle(next, i, q, m_hullTri[i], -1, m_hullTri[next]);
+					m_hullTri[i] = Legalize(t + 2);
+					m_hullNext[next] = next;
+					next = q;
+					q = m_hullNext[next];
+				}
+
+				// Walk backward from the other side, adding more triangles and flipping
+				if (e == start)
+				{
+					q = m_hullPrev[e];
+
+					while (Orient(x, y, X(q), Y(q), X(e), Y(e)) < 0)
+					{
+						t = AddTriangle(q, i, e, -1, m_hullTri[e], m_hullTri[q]);
+						Legalize(t + 2);
+						m_hullTri[q] = t;
+						m_hullNext[e] = e;
+						e = q;
+						q = m_hullPrev[e];
+					}
+				}
+
+				// Update the hull indices
+				m_hullStart = m_hullPrev[i] = e;
+				m_hullNext[e] = m_hullPrev[next] = i;
+				m_hullNext[i] = next;
+
+				m_hullHash[HashKey(x, y)] = i;
+				m_hullHash[HashKey(X(e), Y(e))] = e;
+			}
+
+			m_triangles.resize(m_trianglesLen);
+			m_halfEdges.resize(m_trianglesLen);
+
+			return true;
+		}
+
+		const std::vector<int>& GetTriangles() const { return m_triangles; }
+		const std::vector<int>& GetHalfEdges() const { return m_halfEdges; }
+
+	private:
+		double X(int i) const { return m_points[i]->GetX(); }
+		double Y(int i) const { return m_points[i]->GetY(); }
+
+		static double DistSquare(double ax, double ay, double bx, double by)
+		{
+			double dx = ax - bx;
+			double dy = ay - by;
+
+			return dx * dx + dy * dy;
+		}
+
+		static double Orient(double px, double py, double qx, double qy, double rx, double ry)
+		{
+			return (qy - py) * (rx - qx) - (qx - px) * (ry - qy);
+		}
+
+		static double CircumRadius(double ax, double ay, double bx, double by, double cx, double cy)
+		{
+			double dx = bx - ax;
+			double dy = by - ay;
+			double ex = cx - ax;
+			double ey = cy - ay;
+
+			double bl = dx * dx + dy * dy;
+			double cl = ex * ex + ey * ey;
+			double denom = dx * ey - dy * ex;
+
+			if (denom == 0.0)
+			{
+				return std::numeric_limits<double>::infinity();
+			}
+
+			double d = 0.5 / denom;
+			double x = (ey * bl - dy * cl) * d;
+			double y = (dx * cl - ex * bl) * d;
+
+			return x * x + y * y;
+		}
+
+		static void CircumCenter(double ax, double ay, double bx, double by, double cx, double cy, double& x, double& y)
+		{
+			double dx = bx - ax;
+			double dy = by - ay;
+			double ex = cx - ax;
+			double ey = cy - ay;
+
+			double bl = dx * dx + dy * dy;
+			double cl = ex * ex + ey * ey;
+			double d = 0.5 / (dx * ey - dy * ex);
+
+			x = ax + (ey * bl - dy * cl) * d;
+			y = ay + (dx * cl - ex * bl) * d;
+		}
+
+		static bool InCircle(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+		{
+			double dx = ax - px;
+			double dy = ay - py;
+			double ex = bx - px;
+			double ey = by - py;
+			double fx = cx - px;
+			double fy = cy - py;
+
+			double ap = dx * dx + dy * dy;
+			double bp = ex * ex + ey * ey;
+			double cp = fx * fx + fy * fy;
+
+			return dx * (ey * cp - bp * fy) - dy * (ex * cp - bp * fx) + ap * (ex * fy - ey * fx) < 0;
+		}
+
+		// Monotonically increases with the real angle, but doesn't need expensive trigonometry
+		int HashKey(double x, double y) const
+		{
+			double dx = x - m_centerX;
+			double dy = y - m_centerY;
+			double sum = std::abs(dx) + std::abs(dy);
+			double p = sum > 0.0 ? dx / sum : 0.0;
+			double angle = (dy > 0 ? 3 - p : 1 + p) / 4;
+
+			return static_cast<int>(floor(angle * m_hashSize)) % m_hashSize;
+		}
+
+		int AddTriangle(int i0, int i1, int i2, int a, int b, int c)
+		{
+			int t = m_trianglesLen;
+
+			m_triangles[t] = i0;
+			m_triangles[t + 1] = i1;
+			m_triangles[t + 2] = i2;
+
+			Link(t, a);
+			Link(t + 1, b);
+			Link(t + 2, c);
+
+			m_trianglesLen += 3;
+
+			return t;
+		}
+
+		void Link(int a, int b)
+		{
+			m_halfEdges[a] = b;
+			if (b != -1)
+			{
+				m_halfEdges[b] = a;
+			}
+		}
+
+		// Flips the edge a and its neighbours recursively until they satisfy the Delaunay condition
+		int Legalize(int a)
+		{
+			int ar = 0;
+
+			while (true)
+			{
+				const int b = m_halfEdges[a];
+				const int a0 = a - a % 3;
+				ar = a0 + (a + 2) % 3;
+
+				// Convex hull edge
+				if (b == -1)
+				{
+					if (m_edgeStack.empty())
+					{
+						break;
+					}
+
+					a = m_edgeStack.back();
+					m_edgeStack.pop_back();
+					continue;
+				}
+
+				const int b0 = b - b % 3;
+				const int al = a0 + (a + 1) % 3;
+				const int bl = b0 + (b + 2) % 3;
+
+				const int p0 = m_triangles[ar];
+				const int pr = m_triangles[a];
+				const int pl = m_triangles[al];
+				const int p1 = m_triangles[bl];
+
+				if (InCircle(X(p0), Y(p0), X(pr), Y(pr), X(pl), Y(pl), X(p1), Y(p1)))
+				{
+					m_triangles[a] = p1;
+					m_triangles[b] = p0;
+
+					const int hbl = m_halfEdges[bl];
+
+					// Edge swapped on the other side of the hull; fix the halfedge reference
+					if (hbl == -1)
+					{
+						int e = m_hullStart;
+						do
+						{
+							if (m_hullTri[e] == bl)
+							{
+								m_hullTri[e] = a;
+								break;
+							}
+
+							e = m_hullPrev[e];
+						} while (e != m_hullStart);
+					}
+
+					Link(a, hbl);
+					Link(b, m_halfEdges[ar]);
+					Link(ar, bl);
+
+					m_edgeStack.push_back(b0 + (b + 1) % 3);
+				}
+				else
+				{
+					if (m_edgeStack.empty())
+					{
+						break;
+					}
+
+					a = m_edgeStack.back();
+					m_edgeStack.pop_back();
+				}
+			}
+
+			return ar;
+		}
+
+		const std::vector<const Vertex*>& m_points;
+
+		std::vector<int> m_triangles;
+		std::vector<int> m_halfEdges;
+		std::vector<int> m_hullPrev;
+		std::vector<int> m_hullNext;
+		std::vector<int> m_hullTri;
+		std::vector<int> m_hullHash;
+		std::vector<int> m_edgeStack;
+
+		double m_centerX;
+		double m_centerY;
+		int m_hashSize;
+		int m_hullStart;
+		int m_trianglesLen;
+	};
+
 	void Delaunay::Triangulate(const VertexSet& vertices, TriangleSet& output)
+	{
+		switch (m_algorithm)
+		{
+		case Algorithm::BowyerWatson:
+			TriangulateBowyerWatson(vertices, output);
+			break;
+		case Algorithm::SweepHull:
+		default:
+			TriangulateSweepHull(vertices, output);
+			break;
+		}
+	}
+
+	void Delaunay::Triangulate(const std::vector<Vertex>& vertices, std::vector<unsigned int>& triangles)
+	{
+		std::vector<unsigned int> halfEdges;
+
+		Triangulate(vertices, triangles, halfEdges);
+	}
+
+	void Delaunay::Triangulate(const std::vector<Vertex>& vertices, std::vector<unsigned int>& triangles, std::vector<unsigned int>& halfEdges)
+	{
+		triangles.clear();
+		halfEdges.clear();
+
+		if (vertices.size() < 3)
+		{
+			return;
+		}
+
+		if (m_algorithm == Algorithm::SweepHull)
+		{
+			std::vector<const Vertex*> points(vertices.size());
+
+			for (size_t i = 0; i < vertices.size(); ++i)
+			{
+				points[i] = &vertices[i];
+			}
+
+			SweepHullBuilder builder(points);
+			if (!builder.Build())
+			{
+				return;
+			}
+
+			const std::vector<int>& output = builder.GetTriangles();
+			triangles.assign(output.begin(), output.end());
+
+			// -1 converts to NO_HALF_EDGE
+			const std::vector<int>& twins = builder.GetHalfEdges();
+			halfEdges.assign(twins.begin(), twins.end());
+
+			return;
+		}
+
+		// The Bowyer-Watson backend works on a VertexSet, map its vertices back to the first matching index
+		std::vector<unsigned int> order(vertices.size());
+
+		for (unsigned int i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+
+		std::stable_sort(order.begin(), order.end(), [&vertices](unsigned int a, unsigned int b)
+		{
+			return vertices[a] < vertices[b];
+		});
+
+		order.erase(std::unique(order.begin(), order.end(), [&vertices](unsigned int a, unsigned int b)
+		{
+			return vertices[a] == vertices[b];
+		}), order.end());
+
+		VertexSet vertexSet(vertices.begin(), vertices.end());
+		std::unordered_map<const Vertex*, unsigned int> vertexIndices;
+		size_t k = 0;
+
+		for (cVertexIterator iterVertex = vertexSet.begin(); iterVertex != vertexSet.end(); ++iterVertex)
+		{
+			vertexIndices[&(*iterVertex)] = order[k++];
+		}
+
+		TriangleSet output;
+		TriangulateBowyerWatson(vertexSet, output);
+		triangles.reserve(output.size() * 3);
+
+		for (auto& triangle : output)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				triangles.push_back(vertexIndices[triangle.GetVertex(i)]);
+			}
+		}
+
+		// Its triangles are not consistently oriented, so pair the half-edges by their unordered end points
+		std::unordered_map<uint64_t, unsigned int> openHalfEdges;
+		openHalfEdges.reserve(triangles.size());
+		halfEdges.assign(triangles.size(), NO_HALF_EDGE);
+
+		for (unsigned int e = 0; e < triangles.size(); ++e)
+		{
+			unsigned int a = triangles[e];
+			unsigned int b = triangles[e % 3 == 2 ? e - 2 : e + 1];
+			uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+
+			auto iter = openHalfEdges.find(key);
+			if (iter == openHalfEdges.end())
+			{
+				openHalfEdges[key] = e;
+			}
+			else
+			{
+				halfEdges[e] = iter->second;
+				halfEdges[iter->second] = e;
+				openHalfEdges.erase(iter);
+			}
+		}
+	}
+
+	void Delaunay::TriangulateBowyerWatson(const VertexSet& vertices, TriangleSet& output)
 	{
 		if (vertices.size() < 3)
 		{
@@ -295,6 +865,35 @@ namespace DelaunayTriangulation
 		}
 	}
 
+	void Delaunay::TriangulateSweepHull(const VertexSet& vertices, TriangleSet& output)
+	{
+		if (vertices.size() < 3)
+		{
+			return;
+		}
+
+		std::vector<const Vertex*> points;
+		points.reserve(vertices.size());
+
+		for (cVertexIterator iterVertex = vertices.begin(); iterVertex != vertices.end(); ++iterVertex)
+		{
+			points.push_back(&(*iterVertex));
+		}
+
+		SweepHullBuilder builder(points);
+		if (!builder.Build())
+		{
+			return;
+		}
+
+		const std::vector<int>& triangles = builder.GetTriangles();
+
+		for (size_t t = 0; t < triangles.size(); t += 3)
+		{
+			output.insert(output.end(), Triangle(points[triangles[t]], points[triangles[t + 1]], points[triangles[t + 2]]));
+		}
+	}
+
 	void Delaunay::TrianglesToEdges(const TriangleSet& triangles, EdgeSet& edges)
 	{
 		for (cTriangleIterator iter = triangles.begin(); iter != triangles.end(); ++iter)
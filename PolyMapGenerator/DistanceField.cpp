@@ -0,0 +1,65 @@
+#include "DistanceField.h"
+
+const unsigned int DistanceField::UNREACHED;
+
+DistanceField::DistanceField() : m_capacity(0), m_pending(0), m_pushCount(0)
+{
+
+}
+
+void DistanceField::Reset(unsigned int vertexCount, const std::vector<unsigned int>& sources, unsigned int maxWeight)
+{
+	if (m_capacity < vertexCount)
+	{
+		m_distances.reset(new std::atomic<unsigned int>[vertexCount]);
+		m_capacity = vertexCount;
+	}
+
+	for (unsigned int v = 0; v < vertexCount; ++v)
+	{
+		m_distances[v].store(UNREACHED, std::memory_order_relaxed);
+	}
+
+	// A push lands at most maxWeight buckets ahead of the one being settled, so the ring never wraps onto itself
+	m_buckets.resize(maxWeight + 1);
+
+	for (auto& bucket : m_buckets)
+	{
+		bucket.clear();
+	}
+
+	m_pending = 0;
+	m_pushCount = 0;
+
+	for (unsigned int source : sources)
+	{
+		if (m_distances[source].load(std::memory_order_relaxed) != 0)
+		{
+			m_distances[source].store(0, std::memory_order_relaxed);
+			Push(source, 0);
+		}
+	}
+}
+
+void DistanceField::Push(unsigned int vertex, unsigned int distance)
+{
+	m_buckets[distance % m_buckets.size()].push_back(vertex);
+	m_pending++;
+	m_pushCount++;
+}
+
+bool DistanceField::PopBucket(unsigned int distance)
+{
+	std::vector<unsigned int>& bucket = m_buckets[distance % m_buckets.size()];
+
+	if (bucket.empty())
+	{
+		return false;
+	}
+
+	m_frontier.swap(bucket);
+	bucket.clear();
+	m_pending -= m_frontier.size();
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,163 @@
+#ifndef DISTANCE_FIELD_H
+#define DISTANCE_FIELD_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <utility>
+#include <algorithm>
+
+#include "Mesh.h"
+#include "ThreadPool.h"
+
+// Multi-source shortest distances over an adjacency with small integer edge weights.
+// Dial's algorithm: a circular array of maxWeight + 1 buckets holds the vertices by tentative distance,
+// so that every vertex is settled once and every edge relaxed once, in O(V + E + maxDistance).
+// The buffers are kept between calls, a field can be reused for any number of graphs.
+class DistanceField
+{
+public:
+	static const unsigned int UNREACHED = 0xFFFFFFFF;
+
+	DistanceField();
+
+	~DistanceField() = default;
+
+	DistanceField(const DistanceField& field) = delete;
+	DistanceField(DistanceField&& field) = delete;
+
+	DistanceField& operator=(const DistanceField& field) = delete;
+	DistanceField& operator=(DistanceField&& field) = delete;
+
+	// weight(from, to) is the cost of stepping from a vertex to its neighbour, in [0, maxWeight]
+	template <typename Weight>
+	void Compute(const Adjacency& adjacency, unsigned int vertexCount, const std::vector<unsigned int>& sources, unsigned int maxWeight, Weight weight);
+	// Same distances as Compute, the vertices of a bucket are relaxed in parallel when there are enough of them.
+	// weight is called from several threads at once.
+	template <typename Weight>
+	void ComputeParallel(const Adjacency& adjacency, unsigned int vertexCount, const std::vector<unsigned int>& sources, unsigned int maxWeight, ThreadPool& pool, Weight weight);
+
+	// UNREACHED if no source leads to the vertex
+	unsigned int GetDistance(unsigned int vertex) const { return m_distances[vertex].load(std::memory_order_relaxed); }
+	// Vertices pushed on the buckets by the last computation, sources included
+	unsigned int GetPushCount() const { return m_pushCount; }
+
+private:
+	void Reset(unsigned int vertexCount, const std::vector<unsigned int>& sources, unsigned int maxWeight);
+	void Push(unsigned int vertex, unsigned int distance);
+	// Moves the bucket of distance into the frontier, false once it is empty
+	bool PopBucket(unsigned int distance);
+
+	// Atomic so that the parallel relaxation can lower a distance with a compare and swap
+	std::unique_ptr<std::atomic<unsigned int>[]> m_distances;
+	unsigned int m_capacity;
+	std::vector<std::vector<unsigned int>> m_buckets;
+	std::vector<unsigned int> m_frontier;
+	// Vertex and distance of the pushes of every block of a parallel relaxation
+	std::vector<std::vector<std::pair<unsigned int, unsigned int>>> m_blockPushes;
+	size_t m_pending;
+	unsigned int m_pushCount;
+};
+
+template <typename Weight>
+void DistanceField::Compute(const Adjacency& adjacency, unsigned int vertexCount, const std::vector<unsigned int>& sources, unsigned int maxWeight, Weight weight)
+{
+	Reset(vertexCount, sources, maxWeight);
+
+	for (unsigned int distance = 0; m_pending > 0; ++distance)
+	{
+		// A weight of 0 pushes on the bucket being settled, so it is taken again until it stays empty
+		while (PopBucket(distance))
+		{
+			for (unsigned int v : m_frontier)
+			{
+				// Stale entry, the vertex was pushed again with a shorter distance
+				if (m_distances[v].load(std::memory_order_relaxed) != distance)
+				{
+					continue;
+				}
+
+				for (const unsigned int* n = adjacency.Begin(v); n != adjacency.End(v); ++n)
+				{
+					unsigned int newDistance = distance + weight(v, *n);
+
+					if (newDistance < m_distances[*n].load(std::memory_order_relaxed))
+					{
+						m_distances[*n].store(newDistance, std::memory_order_relaxed);
+						Push(*n, newDistance);
+					}
+				}
+			}
+		}
+	}
+}
+
+template <typename Weight>
+void DistanceField::ComputeParallel(const Adjacency& adjacency, unsigned int vertexCount, const std::vector<unsigned int>& sources, unsigned int maxWeight, ThreadPool& pool, Weight weight)
+{
+	// Smallest frontier block worth a task of its own
+	const unsigned int MIN_BLOCK_SIZE = 1024;
+
+	Reset(vertexCount, sources, maxWeight);
+
+	for (unsigned int distance = 0; m_pending > 0; ++distance)
+	{
+		while (PopBucket(distance))
+		{
+			unsigned int frontierSize = static_cast<unsigned int>(m_frontier.size());
+			unsigned int blockCount = std::max(1u, std::min(pool.GetThreadCount() * 4, frontierSize / MIN_BLOCK_SIZE));
+			unsigned int blockSize = (frontierSize + blockCount - 1) / blockCount;
+
+			if (m_blockPushes.size() < blockCount)
+			{
+				m_blockPushes.resize(blockCount);
+			}
+
+			// Every distance only goes down through a compare and swap, so each push is made by the one thread that lowered it
+			pool.ParallelFor(blockCount, 1, [this, &adjacency, &weight, distance, frontierSize, blockSize](unsigned int begin, unsigned int end)
+			{
+				for (unsigned int b = begin; b < end; ++b)
+				{
+					std::vector<std::pair<unsigned int, unsigned int>>& pushes = m_blockPushes[b];
+					unsigned int last = std::min(frontierSize, (b + 1) * blockSize);
+					pushes.clear();
+
+					for (unsigned int i = b * blockSize; i < last; ++i)
+					{
+						unsigned int v = m_frontier[i];
+
+						if (m_distances[v].load(std::memory_order_relaxed) != distance)
+						{
+							continue;
+						}
+
+						for (const unsigned int* n = adjacency.Begin(v); n != adjacency.End(v); ++n)
+						{
+							unsigned int newDistance = distance + weight(v, *n);
+							unsigned int current = m_distances[*n].load(std::memory_order_relaxed);
+
+							while (newDistance < current)
+							{
+								if (m_distances[*n].compare_exchange_weak(current, newDistance, std::memory_order_relaxed))
+								{
+									pushes.push_back(std::make_pair(*n, newDistance));
+									break;
+								}
+							}
+						}
+					}
+				}
+			});
+
+			for (unsigned int b = 0; b < blockCount; ++b)
+			{
+				for (const auto& push : m_blockPushes[b])
+				{
+					Push(push.first, push.second);
+				}
+			}
+		}
+	}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,394 @@
+#include <cassert>
+#include <algorithm>
+
+#include "LinearQuadTree.h"
+
+namespace
+{
+	// Spreads the low 16 bits of v to the even bits
+	unsigned int SpreadBits(unsigned int v)
+	{
+		v &= 0x0000FFFF;
+		v = (v | (v << 8)) & 0x00FF00FF;
+		v = (v | (v << 4)) & 0x0F0F0F0F;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+
+		return v;
+	}
+}
+
+const unsigned int LinearQuadTree::MAX_DEPTH;
+
+LinearQuadTree::LinearQuadTree() :
+	m_depth(0), m_side(1)
+{
+
+}
+
+void LinearQuadTree::Build(const std::vector<AABB>& bounds, const std::vector<Vector2>& positions, AABB boundary, unsigned int depth)
+{
+	assert(bounds.size() == positions.size());
+
+	Clear();
+
+	m_boundary = boundary;
+	m_depth = std::min(depth, MAX_DEPTH);
+	m_side = 1u << m_depth;
+	m_origin = boundary.m_pos - boundary.m_half;
+	m_leafSize = Vector2(2 * boundary.m_half.x / m_side, 2 * boundary.m_half.y / m_side);
+	m_inverseLeafSize = Vector2(boundary.m_half.x > 0.0 ? 1.0 / m_leafSize.x : 0.0, boundary.m_half.y > 0.0 ? 1.0 / m_leafSize.y : 0.0);
+	m_bounds = bounds;
+	m_positions = positions;
+
+	unsigned int elementCount = static_cast<unsigned int>(bounds.size());
+
+	// Leaf rectangle overlapped by every element, empty for elements outside the boundary
+	std::vector<unsigned int> ranges(elementCount * 4, 0);
+	m_homeLeaves.resize(elementCount);
+
+	for (unsigned int element = 0; element < elementCount; ++element)
+	{
+		unsigned int* range = &ranges[element * 4];
+		m_homeLeaves[element] = EncodeMorton(GetColumn(positions[element].x), GetRow(positions[element].y));
+
+		if (!boundary.IsIntersect(bounds[element]))
+		{
+			continue;
+		}
+
+		Vector2 minPoint = bounds[element].m_pos - bounds[element].m_half;
+		Vector2 maxPoint = bounds[element].m_pos + bounds[element].m_half;
+
+		range[0] = GetColumn(minPoint.x);
+		range[1] = GetRow(minPoint.y);
+		range[2] = GetColumn(maxPoint.x) + 1;
+		range[3] = GetRow(maxPoint.y) + 1;
+	}
+
+	// Whether the home leaf of an element lies outside its leaf rectangle and needs its own entry
+	auto isHomeOutside = [this, &ranges](unsigned int element)
+	{
+		const unsigned int* range = &ranges[element * 4];
+		const Vector2& position = m_positions[element];
+		unsigned int column = GetColumn(position.x);
+		unsigned int row = GetRow(position.y);
+
+		return column < range[0] || column >= range[2] || row < range[1] || row >= range[3];
+	};
+
+	// Counting pass, then a fill pass in element order so that every leaf lists its elements sorted
+	m_leafOffsets.assign(GetLeafCount() + 1, 0);
+
+	for (unsigned int element = 0; element < elementCount; ++element)
+	{
+		const unsigned int* range = &ranges[element * 4];
+
+		for (unsigned int y = range[1]; y < range[3]; ++y)
+		{
+			for (unsigned int x = range[0]; x < range[2]; ++x)
+			{
+				m_leafOffsets[EncodeMorton(x, y) + 1]++;
+			}
+		}
+
+		if (isHomeOutside(element))
+		{
+			m_leafOffsets[m_homeLeaves[element] + 1]++;
+		}
+	}
+
+	for (size_t leaf = 1; leaf < m_leafOffsets.size(); ++leaf)
+	{
+		m_leafOffsets[leaf] += m_leafOffsets[leaf - 1];
+	}
+
+	std::vector<unsigned int> cursors(m_leafOffsets.begin(), m_leafOffsets.end() - 1);
+	m_leafElements.resize(m_leafOffsets.back());
+
+	for (unsigned int element = 0; element < elementCount; ++element)
+	{
+		const unsigned int* range = &ranges[element * 4];
+
+		for (unsigned int y = range[1]; y < range[3]; ++y)
+		{
+			for (unsigned int x = range[0]; x < range[2]; ++x)
+			{
+				m_leafElements[cursors[EncodeMorton(x, y)]++] = element;
+			}
+		}
+
+		if (isHomeOutside(element))
+		{
+			m_leafElements[cursors[m_homeLeaves[element]]++] = element;
+		}
+	}
+}
+
+void LinearQuadTree::Clear()
+{
+	m_depth = 0;
+	m_side = 1;
+	m_bounds.clear();
+	m_positions.clear();
+	m_homeLeaves.clear();
+	m_leafOffsets.clear();
+	m_leafElements.clear();
+}
+
+void LinearQuadTree::QueryPoint(Vector2 position, std::vector<unsigned int>& elements) const
+{
+	elements.clear();
+
+	unsigned int leaf = GetLeaf(position);
+
+	if (leaf >= GetLeafCount() || m_leafOffsets.empty())
+	{
+		return;
+	}
+
+	for (unsigned int i = m_leafOffsets[leaf]; i < m_leafOffsets[leaf + 1]; ++i)
+	{
+		if (m_bounds[m_leafElements[i]].IsContain(position))
+		{
+			elements.push_back(m_leafElements[i]);
+		}
+	}
+}
+
+void LinearQuadTree::QueryRange(const AABB& range, std::vector<unsigned int>& elements) const
+{
+	elements.clear();
+
+	if (m_leafOffsets.empty() || !m_boundary.IsIntersect(range))
+	{
+		return;
+	}
+
+	Vector2 minPoint = range.m_pos - range.m_half;
+	Vector2 maxPoint = range.m_pos + range.m_half;
+
+	for (unsigned int row = GetRow(minPoint.y); row <= GetRow(maxPoint.y); ++row)
+	{
+		for (unsigned int column = GetColumn(minPoint.x); column <= GetColumn(maxPoint.x); ++column)
+		{
+			unsigned int leaf = EncodeMorton(column, row);
+
+			for (unsigned int i = m_leafOffsets[leaf]; i < m_leafOffsets[leaf + 1]; ++i)
+			{
+				unsigned int element = m_leafElements[i];
+				const AABB& bounds = m_bounds[element];
+
+				if (!bounds.IsIntersect(range))
+				{
+					continue;
+				}
+
+				// Only the leaf holding the lowest corner of the overlap reports the element
+				Vector2 elementMin = bounds.m_pos - bounds.m_half;
+
+				if (GetColumn(std::max(elementMin.x, minPoint.x)) == column && GetRow(std::max(elementMin.y, minPoint.y)) == row)
+				{
+					elements.push_back(element);
+				}
+			}
+		}
+	}
+}
+
+void LinearQuadTree::QueryRadius(Vector2 position, double radius, std::vector<unsigned int>& elements) const
+{
+	elements.clear();
+
+	if (m_leafOffsets.empty() || !(radius >= 0.0))
+	{
+		return;
+	}
+
+	double squaredRadius = radius * radius;
+
+	for (unsigned int row = GetRow(position.y - radius); row <= GetRow(position.y + radius); ++row)
+	{
+		for (unsigned int column = GetColumn(position.x - radius); column <= GetColumn(position.x + radius); ++column)
+		{
+			unsigned int leaf = EncodeMorton(column, row);
+
+			for (unsigned int i = m_leafOffsets[leaf]; i < m_leafOffsets[leaf + 1]; ++i)
+			{
+				unsigned int element = m_leafElements[i];
+
+				if (m_homeLeaves[element] != leaf)
+				{
+					continue;
+				}
+
+				double dx = m_positions[element].x - position.x;
+				double dy = m_positions[element].y - position.y;
+
+				if (dx * dx + dy * dy <= squaredRadius)
+				{
+					elements.push_back(element);
+				}
+			}
+		}
+	}
+}
+
+void LinearQuadTree::QueryNearest(Vector2 position, unsigned int count, std::vector<unsigned int>& elements) const
+{
+	elements.clear();
+
+	if (m_leafOffsets.empty() || count == 0)
+	{
+		return;
+	}
+
+	auto squaredDistance = [this, &position](unsigned int element)
+	{
+		double dx = m_positions[element].x - position.x;
+		double dy = m_positions[element].y - position.y;
+
+		return dx * dx + dy * dy;
+	};
+
+	// Insertion into the sorted result, dropping the farthest element once it is full
+	auto visitLeaf = [this, count, &elements, &squaredDistance](unsigned int leaf)
+	{
+		for (unsigned int i = m_leafOffsets[leaf]; i < m_leafOffsets[leaf + 1]; ++i)
+		{
+			unsigned int element = m_leafElements[i];
+
+			if (m_homeLeaves[element] != leaf)
+			{
+				continue;
+			}
+
+			double distance = squaredDistance(element);
+
+			if (elements.size() == count)
+			{
+				double lastDistance = squaredDistance(elements.back());
+
+				if (distance > lastDistance || (distance == lastDistance && element > elements.back()))
+				{
+					continue;
+				}
+
+				elements.pop_back();
+			}
+
+			size_t slot = elements.size();
+			elements.push_back(element);
+
+			while (slot > 0)
+			{
+				unsigned int previous = elements[slot - 1];
+				double previousDistance = squaredDistance(previous);
+
+				if (previousDistance < distance || (previousDistance == distance && previous < element))
+				{
+					break;
+				}
+
+				elements[slot] = previous;
+				slot--;
+			}
+
+			elements[slot] = element;
+		}
+	};
+
+	int side = static_cast<int>(m_side);
+	int centerColumn = static_cast<int>(GetColumn(position.x));
+	int centerRow = static_cast<int>(GetRow(position.y));
+	double minLeafSize = std::min(m_leafSize.x, m_leafSize.y);
+
+	// Ring r holds the leaves r columns or rows away from the leaf of position, all of them at least (r - 1) leaves away
+	for (int ring = 0; ring < side; ++ring)
+	{
+		if (ring > 0 && elements.size() == count)
+		{
+			double reach = (ring - 1) * minLeafSize;
+
+			if (squaredDistance(elements.back()) <= reach * reach)
+			{
+				break;
+			}
+		}
+
+		int firstColumn = std::max(centerColumn - ring, 0);
+		int lastColumn = std::min(centerColumn + ring, side - 1);
+
+		for (int row = std::max(centerRow - ring, 0); row <= std::min(centerRow + ring, side - 1); ++row)
+		{
+			if (row == centerRow - ring || row == centerRow + ring)
+			{
+				for (int column = firstColumn; column <= lastColumn; ++column)
+				{
+					visitLeaf(EncodeMorton(column, row));
+				}
+			}
+			else
+			{
+				if (centerColumn - ring >= 0)
+				{
+					visitLeaf(EncodeMorton(centerColumn - ring, row));
+				}
+				if (centerColumn + ring < side)
+				{
+					visitLeaf(EncodeMorton(centerColumn + ring, row));
+				}
+			}
+		}
+	}
+}
+
+unsigned int LinearQuadTree::GetDepth() const
+{
+	return m_depth;
+}
+
+const AABB& LinearQuadTree::GetBoundary() const
+{
+	return m_boundary;
+}
+
+unsigned int LinearQuadTree::GetElementCount() const
+{
+	return static_cast<unsigned int>(m_bounds.size());
+}
+
+unsigned int LinearQuadTree::EncodeMorton(unsigned int x, unsigned int y)
+{
+	return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+unsigned int LinearQuadTree::GetLeafCount() const
+{
+	return m_side * m_side;
+}
+
+unsigned int LinearQuadTree::GetLeaf(Vector2 position) const
+{
+	if (!m_boundary.IsContain(position))
+	{
+		return GetLeafCount();
+	}
+
+	return EncodeMorton(GetColumn(position.x), GetRow(position.y));
+}
+
+unsigned int LinearQuadTree::GetColumn(double x) const
+{
+	double column = (x - m_origin.x) * m_inverseLeafSize.x;
+
+	// Written so that NaN also lands in the first column
+	return column > 0.0 ? std::min(static_cast<unsigned int>(std::min(column, static_cast<double>(m_side))), m_side - 1) : 0;
+}
+
+unsigned int LinearQuadTree::GetRow(double y) const
+{
+	double row = (y - m_origin.y) * m_inverseLeafSize.y;
+
+	return row > 0.0 ? std::min(static_cast<unsigned int>(std::min(row, static_cast<double>(m_side))), m_side - 1) : 0;
+}
\ No newline at end of file
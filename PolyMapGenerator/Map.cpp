@@ -1,13 +1,47 @@
 #include <iostream>
+#include <cassert>
 #include <random>
-#include <queue>
+#include <algorithm>
 #include <SFML/System.hpp>
 
 #include "Map.h"
+#include "MapFile.h"
+#include "TaskGraph.h"
 #include "PoissonDiskSampling/PoissonDiskSampling.h"
 #include "Math/Vector2.h"
 #include "Noise/Noise.h"
 
+namespace
+{
+	// Data channels read and written by the generation stages
+	const TaskGraph::ChannelMask CHANNEL_POLYGONS = 1 << 0;
+	const TaskGraph::ChannelMask CHANNEL_CORNER_FLAGS = 1 << 1;
+	const TaskGraph::ChannelMask CHANNEL_CENTER_FLAGS = 1 << 2;
+	const TaskGraph::ChannelMask CHANNEL_CORNER_ELEVATION = 1 << 3;
+	const TaskGraph::ChannelMask CHANNEL_CENTER_ELEVATION = 1 << 4;
+	const TaskGraph::ChannelMask CHANNEL_DOWNSLOPES = 1 << 5;
+	const TaskGraph::ChannelMask CHANNEL_RIVERS = 1 << 6;
+	const TaskGraph::ChannelMask CHANNEL_CORNER_MOISTURE = 1 << 7;
+	const TaskGraph::ChannelMask CHANNEL_CENTER_MOISTURE = 1 << 8;
+	const TaskGraph::ChannelMask CHANNEL_BIOMES = 1 << 9;
+	const TaskGraph::ChannelMask CHANNEL_QUADTREE = 1 << 10;
+	const TaskGraph::ChannelMask CHANNEL_NODE_ATTRIBUTES = 1 << 11;
+	const TaskGraph::ChannelMask CHANNEL_WORKSPACE = 1 << 12;
+	const TaskGraph::ChannelMask CHANNEL_CENTER_GRID = 1 << 13;
+	const TaskGraph::ChannelMask CHANNEL_ATTRIBUTES = CHANNEL_CORNER_FLAGS | CHANNEL_CENTER_FLAGS | CHANNEL_CORNER_ELEVATION |
+		CHANNEL_CENTER_ELEVATION | CHANNEL_DOWNSLOPES | CHANNEL_RIVERS | CHANNEL_CORNER_MOISTURE | CHANNEL_CENTER_MOISTURE | CHANNEL_BIOMES;
+
+	// Multiple of 64 so that parallel loops never write the same BitSet word
+	const unsigned int GRAIN_SIZE = 1024;
+
+	// Corner elevation steps, in hundredths
+	const unsigned int WATER_STEP = 1;
+	const unsigned int LAND_STEP = 101;
+
+	// Center indices of the last lookup or area query of the thread, kept to reuse the allocation
+	thread_local std::vector<unsigned int> t_centerIndices;
+}
+
 const std::vector<std::vector<BiomeType>> Map::m_elevationMoistureMatrix = MakeBiomeMatrix();
 
 std::vector<std::vector<BiomeType>> Map::MakeBiomeMatrix()
@@ -62,127 +96,114 @@ std::vector<std::vector<BiomeType>> Map::MakeBiomeMatrix()
 
 Map::Map(int width, int height, double pointSpread, std::string seed) :
 	m_mapWidth(width), m_mapHeight(height), m_pointSpread(pointSpread), m_zCoord(0.0),
-	m_noiseMap(nullptr), m_seed(seed), m_centersQuadTree(AABB(Vector2(width / 2, height / 2), Vector2(width / 2, height / 2)), 1)
+	m_noiseMap(nullptr), m_seed(seed), m_staleChannels(~static_cast<TaskGraph::ChannelMask>(0)), m_triangulationAlgorithm(DelaunayTriangulation::Algorithm::SweepHull), m_threadCount(0), m_verbose(false), m_threadPool(nullptr), m_workspace(nullptr), m_instrumentation(nullptr)
 {
-	double approxPointCount = (2 * m_mapWidth * m_mapHeight) / (3.1416 * m_pointSpread * m_pointSpread);
-	int maxTreeDepth = static_cast<int>(floor((log(approxPointCount) / log(4)) + 0.5));
-	QuadTree<Center*>::SetMaxDepth(maxTreeDepth);
-
 	m_seed = seed != "" ? seed : CreateSeed(20);
 	std::mt19937 mt_rand(HashString(m_seed));
 
+	// Every random stage draws from its own generator seeded here, in a fixed order,
+	// so the output only depends on the seed and the parameters
 	m_zCoord = mt_rand();
-	std::cout << "Seed: " << m_seed << "(" << HashString(m_seed) << ")" << std::endl;
+	m_pointSeed = mt_rand();
+	m_noiseSeed = mt_rand();
+	m_riverSeed = mt_rand();
 }
 
 void Map::Generate()
 {
-	sf::Clock timer;
+	if (m_verbose)
+	{
+		std::cout << "Seed: " << m_seed << "(" << HashString(m_seed) << ")" << std::endl;
+	}
+
+	m_stageTimes.clear();
+
+	if ((m_staleChannels & CHANNEL_POLYGONS) != 0)
+	{
+		GeneratePolygons();
+	}
 
-	GeneratePolygons();
+	// A stage runs if it produces a stale channel or reads a channel rewritten by a stage that runs before it.
+	// Stages are added in pipeline order, so a single pass finds every one of them.
+	TaskGraph graph;
+	TaskGraph::ChannelMask rewritten = m_staleChannels & CHANNEL_POLYGONS;
 
-	std::cout << "Land distribution: ";
-	timer.restart();
-	GenerateLand();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
+	auto addStage = [this, &graph, &rewritten](std::string name, TaskGraph::ChannelMask inputs, TaskGraph::ChannelMask outputs, std::function<void()> function)
+	{
+		if ((outputs & m_staleChannels) != 0 || (inputs & rewritten) != 0)
+		{
+			graph.AddStage(name, inputs, outputs, [this, name, function]() { RunStage(name, function); });
+			rewritten |= outputs;
+		}
+	};
+
+	addStage("Land distribution", CHANNEL_POLYGONS, CHANNEL_CORNER_FLAGS | CHANNEL_WORKSPACE, [this]() { GenerateLand(); });
 
 	// Elevation
-	std::cout << "Coast assignment: ";
-	timer.restart();
-	AssignOceanCoastLand();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "Corner altitude: ";
-	timer.restart();
-	AssignCornerElevations();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "Altitude redistribution: ";
-	timer.restart();
-	RedistributeElevations();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "Center altitude: ";
-	timer.restart();
-	AssignPolygonElevations();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
+	addStage("Coast assignment", CHANNEL_CORNER_FLAGS, CHANNEL_CORNER_FLAGS | CHANNEL_CENTER_FLAGS | CHANNEL_WORKSPACE, [this]() { AssignOceanCoastLand(); });
+	addStage("Corner altitude", CHANNEL_CORNER_FLAGS, CHANNEL_CORNER_ELEVATION | CHANNEL_WORKSPACE, [this]() { AssignCornerElevations(); });
+	addStage("Altitude redistribution", CHANNEL_CORNER_FLAGS | CHANNEL_CORNER_ELEVATION, CHANNEL_CORNER_ELEVATION | CHANNEL_WORKSPACE, [this]() { RedistributeElevations(); });
+	addStage("Center altitude", CHANNEL_CORNER_ELEVATION, CHANNEL_CENTER_ELEVATION, [this]() { AssignPolygonElevations(); });
 
 	// Moisture
-	std::cout << "Downslopes: ";
-	timer.restart();
-	CalculateDownslopes();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "River generation: ";
-	timer.restart();
-	GenerateRivers();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "Corner moisture: ";
-	timer.restart();
-	AssignCornerMoisture();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "Moisture redistribution: ";
-	timer.restart();
-	RedistributeMoisture();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-
-	std::cout << "Center moisture: ";
-	timer.restart();
-	AssignPolygonMoisture();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
+	addStage("Downslopes", CHANNEL_CORNER_ELEVATION, CHANNEL_DOWNSLOPES, [this]() { CalculateDownslopes(); });
+	addStage("River generation", CHANNEL_CORNER_FLAGS | CHANNEL_CORNER_ELEVATION | CHANNEL_DOWNSLOPES, CHANNEL_RIVERS, [this]() { GenerateRivers(); });
+	addStage("Corner moisture", CHANNEL_CORNER_FLAGS | CHANNEL_RIVERS, CHANNEL_CORNER_MOISTURE | CHANNEL_WORKSPACE, [this]() { AssignCornerMoisture(); });
+	addStage("Moisture redistribution", CHANNEL_CORNER_FLAGS | CHANNEL_CORNER_MOISTURE, CHANNEL_CORNER_MOISTURE | CHANNEL_WORKSPACE, [this]() { RedistributeMoisture(); });
+	addStage("Center moisture", CHANNEL_CORNER_MOISTURE, CHANNEL_CORNER_MOISTURE | CHANNEL_CENTER_MOISTURE, [this]() { AssignPolygonMoisture(); });
 
 	// Biomes
-	std::cout << "Biome assignment: ";
-	timer.restart();
-	AssignBiomes();
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
+	addStage("Biome assignment", CHANNEL_CENTER_FLAGS | CHANNEL_CENTER_ELEVATION | CHANNEL_CENTER_MOISTURE, CHANNEL_BIOMES, [this]() { AssignBiomes(); });
 
-	std::cout << "Populate Quadtree: ";
-	timer.restart();
-	for (auto center : m_centers)
+	// Only needs the polygons, so it overlaps with every attribute stage
+	addStage("Populate Quadtree", CHANNEL_POLYGONS, CHANNEL_QUADTREE, [this]() { PopulateQuadTree(); });
+	addStage("Center grid", CHANNEL_POLYGONS, CHANNEL_CENTER_GRID, [this]() { BuildCenterGrid(); });
+	addStage("Attribute sync", CHANNEL_ATTRIBUTES, CHANNEL_NODE_ATTRIBUTES, [this]() { m_attributes.Apply(m_centers, m_corners, m_edges); });
+
+	graph.Run(GetThreadPool());
+	m_staleChannels = 0;
+
+	for (unsigned int i = 0; i < graph.GetStageCount(); ++i)
 	{
-		std::pair<Vector2, Vector2> aabb(center->GetBoundingBox());
-		m_centersQuadTree.Insert2(center, AABB(aabb.first, aabb.second));
+		m_stageTimes.push_back({ graph.GetStageName(i), graph.GetStageTime(i) });
 	}
-	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
 }
 
 void Map::GeneratePolygons()
 {
-	sf::Clock timer;
-
-	GeneratePoints();
-	std::cout << "Point placement: " << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-	timer.restart();
-
-	Triangulate(m_points);
-	std::cout << "Triangulation: " << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
-	timer.restart();
-
-	FinishInfo();
-	std::cout << "Finishing touches: " << timer.getElapsedTime().asMicroseconds() / 1000.0 << " ms." << std::endl;
+	m_stageTimes.push_back({ "Point placement", RunStage("Point placement", [this]() { GeneratePoints(); }) });
+	m_stageTimes.push_back({ "Triangulation", RunStage("Triangulation", [this]() { Triangulate(m_points); }) });
+	m_stageTimes.push_back({ "Finishing touches", RunStage("Finishing touches", [this]() { FinishInfo(); }) });
+	m_stageTimes.push_back({ "Mesh build", RunStage("Mesh build", [this]()
+	{
+		m_mesh.Build(m_centers, m_corners, m_edges);
+		m_attributes.Resize(m_mesh);
+	}) });
 }
 
 void Map::GenerateLand()
 {
-	m_noiseMap = new noise::module::Perlin();
+	CornerAttributes& corners = m_attributes.m_corners;
+	m_noiseMap = GetWorkspace().m_noise.get();
+	m_noiseMap->SetSeed(static_cast<int>(m_noiseSeed));
 
 	for (auto corner : m_corners)
 	{
 		if (!corner->IsInsideBoundingBox(m_mapWidth, m_mapHeight))
 		{
-			corner->m_border = true;
-			corner->m_ocean = true;
-			corner->m_water = true;
+			corners.m_border.Set(corner->m_index);
+			corners.m_ocean.Set(corner->m_index);
+			corners.m_water.Set(corner->m_index);
 		}
 	}
 
-	for (auto corner : m_corners)
+	GetThreadPool().ParallelFor(m_mesh.GetCornerCount(), GRAIN_SIZE, [this, &corners](unsigned int begin, unsigned int end)
 	{
-		corner->m_water = !IsIsland(corner->m_position);
-	}
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			corners.m_water.Set(i, !IsIsland(m_mesh.m_cornerPositions[i]));
+		}
+	});
 }
 
 std::vector<Edge*> Map::GetEdges() const
@@ -200,33 +221,261 @@ std::vector<Center*> Map::GetCenters() const
 	return m_centers;
 }
 
-Center* Map::GetCenterAt(Vector2 pos)
+const Mesh& Map::GetMesh() const
 {
-	Center* center = nullptr;
-	std::vector<Center*> auxCenters = m_centersQuadTree.QueryRange(pos);
+	return m_mesh;
+}
 
-	if (auxCenters.size() > 0)
-	{
-		double minDist = Vector2(auxCenters[0]->m_position, pos).Length();
-		center = auxCenters[0];
+const MapAttributes& Map::GetAttributes() const
+{
+	return m_attributes;
+}
 
-		for (auto auxCenter : auxCenters)
+int Map::GetWidth() const
+{
+	return m_mapWidth;
+}
+
+int Map::GetHeight() const
+{
+	return m_mapHeight;
+}
+
+uint64_t Map::GetGraphHash() const
+{
+	return HashGraph(m_mesh, m_attributes);
+}
+
+uint64_t Map::HashGraph(const Mesh& mesh, const MapAttributes& attributes)
+{
+	// 64-bit FNV-1a over the topology, the positions and every attribute channel
+	uint64_t hash = 14695981039346656037ull;
+
+	auto hashBytes = [&hash](const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i < size; ++i)
 		{
-			double newDist = Vector2(auxCenter->m_position, pos).Length();
-			if (newDist < minDist)
-			{
-				minDist = newDist;
-				center = auxCenter;
-			}
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
 		}
+	};
+
+	auto hashVector = [&hashBytes](const auto& v)
+	{
+		uint64_t size = v.size();
+		hashBytes(&size, sizeof(size));
+		hashBytes(v.data(), v.size() * sizeof(v[0]));
+	};
+
+	auto hashBitSet = [&hashBytes](const BitSet& bs)
+	{
+		uint64_t size = bs.Size();
+		hashBytes(&size, sizeof(size));
+		hashBytes(bs.GetWords(), bs.GetWordCount() * sizeof(uint64_t));
+	};
+
+	for (const auto& position : mesh.m_centerPositions)
+	{
+		hashBytes(&position.x, sizeof(double));
+		hashBytes(&position.y, sizeof(double));
+	}
+
+	for (const auto& position : mesh.m_cornerPositions)
+	{
+		hashBytes(&position.x, sizeof(double));
+		hashBytes(&position.y, sizeof(double));
+	}
+
+	for (const Adjacency* adjacency : { &mesh.m_centerCenters, &mesh.m_centerCorners, &mesh.m_centerEdges,
+		&mesh.m_cornerCorners, &mesh.m_cornerCenters, &mesh.m_cornerEdges })
+	{
+		hashVector(adjacency->m_offsets);
+		hashVector(adjacency->m_indices);
+	}
+
+	hashVector(mesh.m_edgeCenters);
+	hashVector(mesh.m_edgeCorners);
+
+	const CenterAttributes& centers = attributes.m_centers;
+	hashVector(centers.m_elevation);
+	hashVector(centers.m_moisture);
+	hashVector(centers.m_biome);
+	hashBitSet(centers.m_water);
+	hashBitSet(centers.m_ocean);
+	hashBitSet(centers.m_coast);
+	hashBitSet(centers.m_border);
+
+	const CornerAttributes& corners = attributes.m_corners;
+	hashVector(corners.m_elevation);
+	hashVector(corners.m_moisture);
+	hashVector(corners.m_riverVolume);
+	hashVector(corners.m_downslope);
+	hashVector(corners.m_downslopeEdge);
+	hashBitSet(corners.m_water);
+	hashBitSet(corners.m_ocean);
+	hashBitSet(corners.m_coast);
+	hashBitSet(corners.m_border);
+
+	hashVector(attributes.m_edges.m_riverVolume);
+
+	return hash;
+}
+
+bool Map::Save(const std::string& path) const
+{
+	return MapFile::Write(path, m_mesh, m_attributes, GetGraphHash());
+}
+
+Center* Map::GetCenterAt(Vector2 pos) const
+{
+	unsigned int center = m_centerGrid.FindCenter(pos);
+
+	return center != Mesh::INVALID_INDEX ? m_centers[center] : nullptr;
+}
+
+void Map::GetCentersAt(Span<const Vector2> positions, Span<Center*> centers) const
+{
+	assert(centers.Size() >= positions.Size());
+
+	std::vector<unsigned int>& indices = t_centerIndices;
+	indices.resize(positions.Size());
+	m_centerGrid.FindCenters(positions, indices);
+
+	for (size_t i = 0; i < positions.Size(); ++i)
+	{
+		centers[i] = indices[i] != Mesh::INVALID_INDEX ? m_centers[indices[i]] : nullptr;
 	}
+}
 
-	return center;
+void Map::GetCentersInRange(const AABB& range, std::vector<Center*>& centers) const
+{
+	m_centersQuadTree.QueryRange(range, t_centerIndices);
+	ToCenters(t_centerIndices, centers);
+}
+
+void Map::GetCentersInRadius(Vector2 pos, double radius, std::vector<Center*>& centers) const
+{
+	m_centersQuadTree.QueryRadius(pos, radius, t_centerIndices);
+	ToCenters(t_centerIndices, centers);
+}
+
+void Map::GetNearestCenters(Vector2 pos, unsigned int count, std::vector<Center*>& centers) const
+{
+	m_centersQuadTree.QueryNearest(pos, count, t_centerIndices);
+	ToCenters(t_centerIndices, centers);
+}
+
+DelaunayTriangulation::Algorithm Map::GetTriangulationAlgorithm() const
+{
+	return m_triangulationAlgorithm;
+}
+
+void Map::SetTriangulationAlgorithm(DelaunayTriangulation::Algorithm algorithm)
+{
+	if (algorithm != m_triangulationAlgorithm)
+	{
+		m_staleChannels = ~static_cast<TaskGraph::ChannelMask>(0);
+	}
+
+	m_triangulationAlgorithm = algorithm;
+}
+
+const MapParameters& Map::GetParameters() const
+{
+	return m_parameters;
+}
+
+void Map::SetParameters(const MapParameters& parameters)
+{
+	const MapParameters& p = m_parameters;
+
+	// Every group marks the first channel computed from it, the in-place stages after it follow on their own
+	if (parameters.m_landMargin != p.m_landMargin || parameters.m_landFalloff != p.m_landFalloff)
+	{
+		m_staleChannels |= CHANNEL_CORNER_FLAGS;
+	}
+
+	if (parameters.m_elevationScale != p.m_elevationScale)
+	{
+		m_staleChannels |= CHANNEL_CORNER_ELEVATION;
+	}
+
+	if (parameters.m_centersPerRiver != p.m_centersPerRiver || parameters.m_riverMinElevation != p.m_riverMinElevation ||
+		parameters.m_riverMaxElevation != p.m_riverMaxElevation)
+	{
+		m_staleChannels |= CHANNEL_RIVERS;
+	}
+
+	if (parameters.m_riverMoisture != p.m_riverMoisture || parameters.m_maxRiverMoisture != p.m_maxRiverMoisture ||
+		parameters.m_freshwaterMoistureDecay != p.m_freshwaterMoistureDecay || parameters.m_oceanMoistureDecay != p.m_oceanMoistureDecay)
+	{
+		m_staleChannels |= CHANNEL_CORNER_MOISTURE;
+	}
+
+	if (parameters.m_hillElevation != p.m_hillElevation || parameters.m_mountainElevation != p.m_mountainElevation ||
+		parameters.m_snowElevation != p.m_snowElevation || parameters.m_beachMoisture != p.m_beachMoisture)
+	{
+		m_staleChannels |= CHANNEL_BIOMES;
+	}
+
+	m_parameters = parameters;
+}
+
+unsigned int Map::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+void Map::SetThreadCount(unsigned int threadCount)
+{
+	m_threadCount = threadCount;
+
+	if (m_threadPool == m_ownedThreadPool.get())
+	{
+		m_threadPool = nullptr;
+	}
+	m_ownedThreadPool.reset();
+}
+
+void Map::SetThreadPool(ThreadPool* threadPool)
+{
+	m_threadPool = threadPool;
+}
+
+void Map::SetWorkspace(MapWorkspace* workspace)
+{
+	m_workspace = workspace;
+}
+
+const std::vector<MapStageTime>& Map::GetStageTimes() const
+{
+	return m_stageTimes;
+}
+
+MapInstrumentation* Map::GetInstrumentation() const
+{
+	return m_instrumentation;
+}
+
+void Map::SetInstrumentation(MapInstrumentation* instrumentation)
+{
+	m_instrumentation = instrumentation;
+}
+
+bool Map::IsVerbose() const
+{
+	return m_verbose;
+}
+
+void Map::SetVerbose(bool verbose)
+{
+	m_verbose = verbose;
 }
 
 bool Map::IsIsland(Vector2 position) const
 {
-	double waterThreshold = 0.075;
+	double waterThreshold = m_parameters.m_landMargin;
 
 	if (position.x < m_mapWidth * waterThreshold || position.y < m_mapHeight * waterThreshold ||
 		position.x > m_mapWidth * (1 - waterThreshold) || position.y > m_mapHeight * (1 - waterThreshold))
@@ -246,349 +495,488 @@ bool Map::IsIsland(Vector2 position) const
 
 	double factor = radius - 0.5;
 
-	return noiseVal >= 0.3 * radius + factor;
+	return noiseVal >= m_parameters.m_landFalloff * radius + factor;
 }
 
 void Map::CalculateDownslopes()
 {
-	for (auto c : m_corners)
+	CornerAttributes& corners = m_attributes.m_corners;
+
+	GetThreadPool().ParallelFor(m_mesh.GetCornerCount(), GRAIN_SIZE, [this, &corners](unsigned int begin, unsigned int end)
 	{
-		Corner* d = c;
-		for (auto q : c->m_corners)
+		for (unsigned int c = begin; c < end; ++c)
 		{
-			if (q->m_elevation < d->m_elevation)
+			unsigned int d = c;
+			unsigned int downslopeEdge = Mesh::INVALID_INDEX;
+
+			// Walks the edges rather than the neighbours so the river edge comes for free
+			for (const unsigned int* e = m_mesh.m_cornerEdges.Begin(c); e != m_mesh.m_cornerEdges.End(c); ++e)
 			{
-				d = q;
+				const unsigned int* edgeCorners = &m_mesh.m_edgeCorners[*e * 2];
+				unsigned int q = edgeCorners[0] != c ? edgeCorners[0] : edgeCorners[1];
+
+				if (q != Mesh::INVALID_INDEX && corners.m_elevation[q] < corners.m_elevation[d])
+				{
+					d = q;
+					downslopeEdge = *e;
+				}
 			}
-		}
 
-		c->m_downslope = d;
-	}
+			corners.m_downslope[c] = d;
+			corners.m_downslopeEdge[c] = downslopeEdge;
+		}
+	});
 }
 
 void Map::GenerateRivers()
 {
-	std::mt19937 mt_rand(HashString(m_seed));
-	int numRivers = m_centers.size() / 3;
+	CornerAttributes& corners = m_attributes.m_corners;
+	std::mt19937 mt_rand(m_riverSeed);
+	int numRivers = static_cast<int>(m_mesh.GetCenterCount() / m_parameters.m_centersPerRiver);
+
+	// Volumes are accumulated, so a rerun starts again from dry edges
+	std::fill(corners.m_riverVolume.begin(), corners.m_riverVolume.end(), 0.0);
+	std::fill(m_attributes.m_edges.m_riverVolume.begin(), m_attributes.m_edges.m_riverVolume.end(), 0.0);
 
 	for (int i = 0; i < numRivers; ++i)
 	{
-		Corner* q = m_corners[mt_rand() % m_corners.size()];
+		unsigned int q = mt_rand() % m_mesh.GetCornerCount();
 
-		if (q->m_ocean || q->m_elevation < 0.3 || q->m_elevation > 0.9)
+		if (corners.m_ocean.Test(q) || corners.m_elevation[q] < m_parameters.m_riverMinElevation || corners.m_elevation[q] > m_parameters.m_riverMaxElevation)
 		{
 			continue;
 		}
 
-		while (!q->m_coast)
+		while (!corners.m_coast.Test(q))
 		{
-			if (q == q->m_downslope)
+			unsigned int downslope = corners.m_downslope[q];
+			if (q == downslope)
 			{
 				break;
 			}
 
-			Edge* e = q->GetEdgeWith(q->m_downslope);
-			e->m_riverVolume += 1;
-			q->m_riverVolume += 1;
-			q->m_downslope->m_riverVolume += 1;
-			q = q->m_downslope;
+			m_attributes.m_edges.m_riverVolume[corners.m_downslopeEdge[q]] += 1;
+			corners.m_riverVolume[q] += 1;
+			corners.m_riverVolume[downslope] += 1;
+			q = downslope;
 		}
 	}
 }
 
 void Map::AssignOceanCoastLand()
 {
-	std::queue<Center*> centersQueue;
+	CenterAttributes& centers = m_attributes.m_centers;
+	CornerAttributes& corners = m_attributes.m_corners;
+	std::vector<unsigned int>& centersQueue = GetWorkspace().m_queue;
+	centersQueue.clear();
 
-	for (auto c : m_centers)
+	// The flood fill only ever sets flags, so a rerun starts again from none
+	centers.m_ocean.Clear();
+	centers.m_border.Clear();
+
+	for (unsigned int c = 0; c < m_mesh.GetCenterCount(); ++c)
 	{
-		int adjacentWater = 0;
-		
-		for (auto q : c->m_corners)
+		unsigned int adjacentWater = 0;
+
+		for (const unsigned int* q = m_mesh.m_centerCorners.Begin(c); q != m_mesh.m_centerCorners.End(c); ++q)
 		{
-			if (q->m_border)
+			if (corners.m_border.Test(*q))
 			{
-				c->m_border = true;
-				c->m_ocean = true;
-				q->m_water = true;
-				centersQueue.push(c);
+				centers.m_border.Set(c);
+				centers.m_ocean.Set(c);
+				corners.m_water.Set(*q);
+				centersQueue.push_back(c);
 			}
 
-			if (q->m_water)
+			if (corners.m_water.Test(*q))
 			{
 				adjacentWater++;
 			}
 		}
 
-		c->m_water = (c->m_ocean || adjacentWater >= c->m_corners.size() * 0.5);
+		centers.m_water.Set(c, centers.m_ocean.Test(c) || adjacentWater >= m_mesh.m_centerCorners.Size(c) * 0.5);
 	}
 
-	while (!centersQueue.empty())
+	for (size_t head = 0; head < centersQueue.size(); ++head)
 	{
-		Center* c = centersQueue.front();
-		centersQueue.pop();
+		unsigned int c = centersQueue[head];
 
-		for (auto r : c->m_centers)
+		for (const unsigned int* r = m_mesh.m_centerCenters.Begin(c); r != m_mesh.m_centerCenters.End(c); ++r)
 		{
-			if (r->m_water && !r->m_ocean)
+			if (centers.m_water.Test(*r) && !centers.m_ocean.Test(*r))
 			{
-				r->m_ocean = true;
-				centersQueue.push(r);
+				centers.m_ocean.Set(*r);
+				centersQueue.push_back(*r);
 			}
 		}
 	}
 
-	for (auto p : m_centers)
-	{
-		int numOcean = 0;
-		int numLand = 0;
+	Count(MapCounter::QueuePushes, centersQueue.size());
 
-		for (auto q : p->m_centers)
+	GetThreadPool().ParallelFor(m_mesh.GetCenterCount(), GRAIN_SIZE, [this, &centers](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int p = begin; p < end; ++p)
 		{
-			numOcean += static_cast<int>(q->m_ocean);
-			numLand += static_cast<int>(!q->m_water);
-		}
+			int numOcean = 0;
+			int numLand = 0;
 
-		p->m_coast = numLand > 0 && numOcean > 0;
-	}
+			for (const unsigned int* q = m_mesh.m_centerCenters.Begin(p); q != m_mesh.m_centerCenters.End(p); ++q)
+			{
+				numOcean += static_cast<int>(centers.m_ocean.Test(*q));
+				numLand += static_cast<int>(!centers.m_water.Test(*q));
+			}
 
-	for (auto c : m_corners)
-	{
-		int adjOcean = 0;
-		int adjLand = 0;
+			centers.m_coast.Set(p, numLand > 0 && numOcean > 0);
+		}
+	});
 
-		for (auto p : c->m_centers)
+	GetThreadPool().ParallelFor(m_mesh.GetCornerCount(), GRAIN_SIZE, [this, &centers, &corners](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int c = begin; c < end; ++c)
 		{
-			adjOcean += static_cast<int>(p->m_ocean);
-			adjLand += static_cast<int>(!p->m_water);
-		}
+			unsigned int adjOcean = 0;
+			unsigned int adjLand = 0;
+			unsigned int numCenters = m_mesh.m_cornerCenters.Size(c);
 
-		c->m_ocean = static_cast<size_t>(adjOcean) == c->m_centers.size();
-		c->m_coast = adjLand > 0 && adjOcean > 0;
-		c->m_water = c->m_border || (static_cast<size_t>(adjLand) != c->m_centers.size() && !c->m_coast);
-	}
+			for (const unsigned int* p = m_mesh.m_cornerCenters.Begin(c); p != m_mesh.m_cornerCenters.End(c); ++p)
+			{
+				adjOcean += static_cast<unsigned int>(centers.m_ocean.Test(*p));
+				adjLand += static_cast<unsigned int>(!centers.m_water.Test(*p));
+			}
+
+			bool coast = adjLand > 0 && adjOcean > 0;
+
+			corners.m_ocean.Set(c, adjOcean == numCenters);
+			corners.m_coast.Set(c, coast);
+			corners.m_water.Set(c, corners.m_border.Test(c) || (adjLand != numCenters && !coast));
+		}
+	});
 }
 
 void Map::RedistributeElevations()
 {
-	std::vector<Corner*> locations = GetLandCorners();
-	const double SCALE_FACTOR = 1.05;
-
-	sort(locations.begin(), locations.end(), &Corner::SortByElevation);
+	MapWorkspace& workspace = GetWorkspace();
+	GetLandCorners(workspace.m_locations);
+	const double SCALE_FACTOR = m_parameters.m_elevationScale;
 
-	for (size_t i = 0; i < locations.size(); ++i)
+	RankTransform(m_attributes.m_corners.m_elevation, workspace.m_locations, workspace.m_rankEntries, workspace.m_rankScratch, GetThreadPool(), [SCALE_FACTOR](double y)
 	{
-		double y = static_cast<double>(i) / (locations.size() - 1);
 		double x = sqrt(SCALE_FACTOR) - sqrt(SCALE_FACTOR * (1 - y));
-		x = std::min(x, 1.0);
-		locations[i]->m_elevation = x;
-	}
+		return std::min(x, 1.0);
+	});
 }
 
 void Map::AssignCornerElevations()
 {
-	std::queue<Corner*> cornersQueue;
-
-	for (auto q : m_corners)
+	CornerAttributes& corners = m_attributes.m_corners;
+	std::vector<double>& elevations = corners.m_elevation;
+	MapWorkspace& workspace = GetWorkspace();
+	std::vector<unsigned int>& borders = workspace.m_queue;
+	DistanceField& distances = workspace.m_distanceField;
+	borders.clear();
+
+	for (unsigned int q = 0; q < m_mesh.GetCornerCount(); ++q)
 	{
-		if (q->m_border)
+		if (corners.m_border.Test(q))
 		{
-			q->m_elevation = 0.0;
-			cornersQueue.push(q);
-		}
-		else
-		{
-			q->m_elevation = 99999;
+			borders.push_back(q);
 		}
 	}
 
-	while (!cornersQueue.empty())
+	// Distance to the border in hundredths: 0.01 per step, 1.01 between two land corners.
+	// Integer weights keep the distances exact, a FIFO with double weights pushed corners again and again.
+	distances.ComputeParallel(m_mesh.m_cornerCorners, m_mesh.GetCornerCount(), borders, LAND_STEP, GetThreadPool(), [&corners](unsigned int q, unsigned int s)
 	{
-		Corner* q = cornersQueue.front();
-		cornersQueue.pop();
+		return !corners.m_water.Test(q) && !corners.m_water.Test(s) ? LAND_STEP : WATER_STEP;
+	});
+
+	Count(MapCounter::QueuePushes, distances.GetPushCount());
 
-		for (auto s : q->m_corners)
+	GetThreadPool().ParallelFor(m_mesh.GetCornerCount(), GRAIN_SIZE, [&corners, &elevations, &distances](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int q = begin; q < end; ++q)
 		{
-			double newElevation = q->m_elevation + 0.01;
+			unsigned int distance = distances.GetDistance(q);
 
-			if (!q->m_water && !s->m_water)
+			if (corners.m_water.Test(q))
 			{
-				newElevation += 1;
+				elevations[q] = 0.0;
 			}
-			
-			if (newElevation < s->m_elevation)
+			else
 			{
-				s->m_elevation = newElevation;
-				cornersQueue.push(s);
+				elevations[q] = distance == DistanceField::UNREACHED ? 99999 : distance * 0.01;
 			}
 		}
-	}
-
-	for (auto q : m_corners)
-	{
-		if (q->m_water)
-		{
-			q->m_elevation = 0.0;
-		}
-	}
+	});
 }
 
 void Map::AssignPolygonElevations()
 {
-	for (auto p : m_centers)
+	const std::vector<double>& cornerElevations = m_attributes.m_corners.m_elevation;
+	std::vector<double>& centerElevations = m_attributes.m_centers.m_elevation;
+
+	GetThreadPool().ParallelFor(m_mesh.GetCenterCount(), GRAIN_SIZE, [this, &cornerElevations, &centerElevations](unsigned int begin, unsigned int end)
 	{
-		double sumElevation = 0.0;
-		for (auto q : p->m_corners)
+		for (unsigned int p = begin; p < end; ++p)
 		{
-			sumElevation += q->m_elevation;
-		}
+			double sumElevation = 0.0;
+			for (const unsigned int* q = m_mesh.m_centerCorners.Begin(p); q != m_mesh.m_centerCorners.End(p); ++q)
+			{
+				sumElevation += cornerElevations[*q];
+			}
 
-		p->m_elevation = sumElevation / p->m_corners.size();
-	}
+			centerElevations[p] = sumElevation / m_mesh.m_centerCorners.Size(p);
+		}
+	});
 }
 
 void Map::RedistributeMoisture()
 {
-	std::vector<Corner*> locations = GetLandCorners();
+	MapWorkspace& workspace = GetWorkspace();
+	GetLandCorners(workspace.m_locations);
 
-	sort(locations.begin(), locations.end(), &Corner::SortByMoisture);
-
-	for (size_t i = 0; i < locations.size(); ++i)
+	RankTransform(m_attributes.m_corners.m_moisture, workspace.m_locations, workspace.m_rankEntries, workspace.m_rankScratch, GetThreadPool(), [](double y)
 	{
-		locations[i]->m_moisture = static_cast<double>(i) / (locations.size() - 1);
-	}
+		return y;
+	});
 }
 
 void Map::AssignCornerMoisture()
 {
-	std::queue<Corner*> cornersQueue;
-
-	for (auto c : m_corners)
+	CornerAttributes& corners = m_attributes.m_corners;
+	std::vector<double>& moistures = corners.m_moisture;
+	MapWorkspace& workspace = GetWorkspace();
+	std::vector<unsigned int>& cornersQueue = workspace.m_queue;
+	DecayPropagation& propagation = workspace.m_moisturePropagation;
+	cornersQueue.clear();
+
+	for (unsigned int c = 0; c < m_mesh.GetCornerCount(); ++c)
 	{
-		if ((c->m_water || c->m_riverVolume > 0) && !c->m_ocean)
+		double riverVolume = corners.m_riverVolume[c];
+
+		if ((corners.m_water.Test(c) || riverVolume > 0) && !corners.m_ocean.Test(c))
 		{
-			c->m_moisture = c->m_riverVolume > 0 ? std::min(3.0, 0.2 * c->m_riverVolume) : 1.0;
-			cornersQueue.push(c);
+			moistures[c] = riverVolume > 0 ? std::min(m_parameters.m_maxRiverMoisture, m_parameters.m_riverMoisture * riverVolume) : 1.0;
+			cornersQueue.push_back(c);
 		}
 		else
 		{
-			c->m_moisture = 0.0;
+			moistures[c] = 0.0;
 		}
 	}
 
-	while (!cornersQueue.empty())
-	{
-		Corner* c = cornersQueue.front();
-		cornersQueue.pop();
+	propagation.Propagate(m_mesh.m_cornerCorners, moistures, cornersQueue, m_parameters.m_freshwaterMoistureDecay, GetThreadPool());
+	Count(MapCounter::QueuePushes, propagation.GetPushCount());
+	cornersQueue.clear();
 
-		for (auto r : c->m_corners)
+	for (unsigned int r = 0; r < m_mesh.GetCornerCount(); ++r)
+	{
+		if (corners.m_ocean.Test(r))
 		{
-			double newMoisture = c->m_moisture * 0.9;
-			
-			if (newMoisture > r->m_moisture)
-			{
-				r->m_moisture = newMoisture;
-				cornersQueue.push(r);
-			}
+			moistures[r] = 1.0;
+			cornersQueue.push_back(r);
 		}
 	}
 
-	for (auto r : m_corners)
+	// Only the corners the ocean raises spread further, the fresh water moisture is not spread a second time
+	propagation.Propagate(m_mesh.m_cornerCorners, moistures, cornersQueue, m_parameters.m_oceanMoistureDecay, GetThreadPool());
+	Count(MapCounter::QueuePushes, propagation.GetPushCount());
+}
+
+void Map::AssignPolygonMoisture()
+{
+	std::vector<double>& cornerMoistures = m_attributes.m_corners.m_moisture;
+	std::vector<double>& centerMoistures = m_attributes.m_centers.m_moisture;
+
+	// Corners are shared between centers, so clamp them in their own pass before averaging
+	GetThreadPool().ParallelFor(m_mesh.GetCornerCount(), GRAIN_SIZE, [&cornerMoistures](unsigned int begin, unsigned int end)
 	{
-		if (r->m_ocean)
+		for (unsigned int q = begin; q < end; ++q)
 		{
-			r->m_moisture = 1.0;
-			cornersQueue.push(r);
+			cornerMoistures[q] = std::min(cornerMoistures[q], 1.0);
 		}
-	}
+	});
 
-	while (!cornersQueue.empty())
+	GetThreadPool().ParallelFor(m_mesh.GetCenterCount(), GRAIN_SIZE, [this, &cornerMoistures, &centerMoistures](unsigned int begin, unsigned int end)
 	{
-		Corner* c = cornersQueue.front();
-		cornersQueue.pop();
-
-		for (auto r : c->m_corners)
+		for (unsigned int p = begin; p < end; ++p)
 		{
-			double newMoisture = c->m_moisture * 0.3;
+			double newMoistrue = 0.0;
 
-			if (newMoisture > r->m_moisture)
+			for (const unsigned int* q = m_mesh.m_centerCorners.Begin(p); q != m_mesh.m_centerCorners.End(p); ++q)
 			{
-				r->m_moisture = newMoisture;
-				cornersQueue.push(r);
+				newMoistrue += cornerMoistures[*q];
 			}
+
+			centerMoistures[p] = newMoistrue / m_mesh.m_centerCorners.Size(p);
 		}
+	});
+}
+
+void Map::AssignBiomes()
+{
+	CenterAttributes& centers = m_attributes.m_centers;
+
+	GetThreadPool().ParallelFor(m_mesh.GetCenterCount(), GRAIN_SIZE, [this, &centers](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int center = begin; center < end; ++center)
+		{
+			centers.m_biome[center] = GetBiome(centers.m_ocean.Test(center), centers.m_water.Test(center), centers.m_coast.Test(center),
+				centers.m_elevation[center], centers.m_moisture[center], m_parameters);
+		}
+	});
+}
+
+BiomeType Map::GetBiome(bool ocean, bool water, bool coast, double elevation, double moisture, const MapParameters& parameters)
+{
+	if (ocean)
+	{
+		return BiomeType::Ocean;
+	}
+	else if (water)
+	{
+		return BiomeType::Lake;
+	}
+	else if (coast && moisture < parameters.m_beachMoisture)
+	{
+		return BiomeType::Beach;
+	}
+
+	int elevationIndex = 0;
+
+	if (elevation > parameters.m_snowElevation)
+	{
+		elevationIndex = 3;
+	}
+	else if (elevation > parameters.m_mountainElevation)
+	{
+		elevationIndex = 2;
 	}
+	else if (elevation > parameters.m_hillElevation)
+	{
+		elevationIndex = 1;
+	}
+	else
+	{
+		elevationIndex = 0;
+	}
+
+	int moistureIndex = std::min(static_cast<int>(floor(moisture * 6)), 5);
+
+	return m_elevationMoistureMatrix[moistureIndex][elevationIndex];
 }
 
-void Map::AssignPolygonMoisture()
+void Map::PopulateQuadTree()
 {
-	for (auto p : m_centers)
+	std::vector<AABB> bounds(m_mesh.GetCenterCount());
+
+	for (unsigned int center = 0; center < m_mesh.GetCenterCount(); ++center)
 	{
-		double newMoistrue = 0.0;
+		const unsigned int* begin = m_mesh.m_centerCorners.Begin(center);
+		const unsigned int* end = m_mesh.m_centerCorners.End(center);
+		Vector2 minPoint = begin != end ? m_mesh.m_cornerPositions[*begin] : m_mesh.m_centerPositions[center];
+		Vector2 maxPoint = minPoint;
 
-		for (auto q : p->m_corners)
+		for (const unsigned int* corner = begin; corner != end; ++corner)
 		{
-			if (q->m_moisture > 1.0)
-			{
-				q->m_moisture = 1.0;
-			}
+			const Vector2& position = m_mesh.m_cornerPositions[*corner];
 
-			newMoistrue += q->m_moisture;
+			minPoint.x = std::min(minPoint.x, position.x);
+			minPoint.y = std::min(minPoint.y, position.y);
+			maxPoint.x = std::max(maxPoint.x, position.x);
+			maxPoint.y = std::max(maxPoint.y, position.y);
 		}
 
-		p->m_moisture = newMoistrue / p->m_corners.size();
+		bounds[center] = AABB((minPoint + maxPoint) / 2, (maxPoint - minPoint) / 2);
 	}
+
+	// About one leaf per center
+	double centerCount = std::max(m_mesh.GetCenterCount(), 1u);
+	unsigned int depth = static_cast<unsigned int>(floor((log(centerCount) / log(4)) + 0.5));
+
+	m_centersQuadTree.Build(bounds, m_mesh.m_centerPositions, AABB(Vector2(m_mapWidth / 2, m_mapHeight / 2), Vector2(m_mapWidth / 2, m_mapHeight / 2)), depth);
 }
 
-void Map::AssignBiomes()
+void Map::BuildCenterGrid()
 {
-	for (auto center : m_centers)
+	// Sites are at least m_pointSpread apart, so a cell of that size overlaps only a handful of polygons
+	m_centerGrid.Build(m_mesh, m_mapWidth, m_mapHeight, m_pointSpread);
+}
+
+double Map::RunStage(const std::string& name, const std::function<void()>& function)
+{
+#if MAP_INSTRUMENTATION
+	if (m_instrumentation != nullptr)
 	{
-		if (center->m_ocean)
-		{
-			center->m_biome = BiomeType::Ocean;
-		}
-		else if (center->m_water)
+		m_instrumentation->BeginStage(name);
+	}
+#endif
+
+	sf::Clock timer;
+	function();
+	double time = timer.getElapsedTime().asMicroseconds() / 1000.0;
+
+#if MAP_INSTRUMENTATION
+	if (m_instrumentation != nullptr)
+	{
+		m_instrumentation->EndStage(name, time);
+		m_instrumentation->SetPeakMemory(MapInstrumentation::GetPeakMemory());
+	}
+#endif
+
+	return time;
+}
+
+void Map::Count(MapCounter counter, uint64_t value)
+{
+#if MAP_INSTRUMENTATION
+	if (m_instrumentation != nullptr)
+	{
+		m_instrumentation->AddCount(counter, value);
+	}
+#endif
+}
+
+ThreadPool& Map::GetThreadPool()
+{
+	if (m_threadPool == nullptr)
+	{
+		if (m_ownedThreadPool == nullptr)
 		{
-			center->m_biome = BiomeType::Lake;
+			m_ownedThreadPool.reset(new ThreadPool(m_threadCount));
 		}
-		else if (center->m_coast && center->m_moisture < 0.6)
+
+		m_threadPool = m_ownedThreadPool.get();
+	}
+
+	return *m_threadPool;
+}
+
+MapWorkspace& Map::GetWorkspace()
+{
+	if (m_workspace == nullptr)
+	{
+		if (m_ownedWorkspace == nullptr)
 		{
-			center->m_biome = BiomeType::Beach;
+			m_ownedWorkspace.reset(new MapWorkspace());
 		}
-		else
-		{
-			int elevationIndex = 0;
-			
-			if (center->m_elevation > 0.85)
-			{
-				elevationIndex = 3;
-			}
-			else if (center->m_elevation > 0.6)
-			{
-				elevationIndex = 2;
-			}
-			else if (center->m_elevation > 0.3)
-			{
-				elevationIndex = 1;
-			}
-			else
-			{
-				elevationIndex = 0;
-			}
 
-			int moistureIndex = std::min(static_cast<int>(floor(center->m_moisture * 6)), 5);
-			center->m_biome = m_elevationMoistureMatrix[moistureIndex][elevationIndex];
-		}
+		m_workspace = m_ownedWorkspace.get();
 	}
+
+	return *m_workspace;
 }
 
 void Map::GeneratePoints()
 {
-	PoissonDiskSampling pds(800, 600, m_pointSpread, 10);
-	std::vector<std::pair<double, double>> newPoints = pds.Generate();
-	std::cout << "Generating " << newPoints.size() << " points..." << std::endl;
+	PoissonDiskSampling pds(m_mapWidth, m_mapHeight, m_pointSpread, 10);
+	// A shared pool is already kept busy by the other maps, so only sample in parallel on an own pool
+	unsigned int threadCount = m_threadPool != m_ownedThreadPool.get() ? 1 : GetThreadPool().GetThreadCount();
+	std::vector<std::pair<double, double>> newPoints = pds.Generate(m_pointSeed, threadCount);
 
+	Count(MapCounter::Points, newPoints.size());
+
+	m_points.clear();
 	for (auto point : newPoints)
 	{
 		m_points.push_back(DelaunayTriangulation::Vertex(static_cast<int>(point.first), static_cast<int>(point.second)));
@@ -606,46 +994,43 @@ void Map::Triangulate(std::vector<DelaunayTriangulation::Vertex> points)
 	m_corners.clear();
 	m_centers.clear();
 	m_edges.clear();
-	m_posCenterMap.clear();
+	m_arena.Reset();
 
-	DelaunayTriangulation::VertexSet vertices(points.begin(), points.end());
-	DelaunayTriangulation::TriangleSet triangles;
-	DelaunayTriangulation::EdgeSet edges;
-	DelaunayTriangulation::Delaunay delaunay;
+	// Sites in the order a VertexSet would give them, without duplicates
+	std::sort(points.begin(), points.end());
+	points.erase(std::unique(points.begin(), points.end()), points.end());
 
-	delaunay.Triangulate(vertices, triangles);
+	std::vector<unsigned int> triangles;
+	std::vector<unsigned int> halfEdges;
+	DelaunayTriangulation::Delaunay delaunay(m_triangulationAlgorithm);
 
-	for (auto t : triangles)
-	{
-		Vector2 posCenter0(t.GetVertex(0)->GetX(), t.GetVertex(0)->GetY());
-		Vector2 posCenter1(t.GetVertex(1)->GetX(), t.GetVertex(1)->GetY());
-		Vector2 posCenter2(t.GetVertex(2)->GetX(), t.GetVertex(2)->GetY());
+	delaunay.Triangulate(points, triangles, halfEdges);
+	Count(MapCounter::Triangles, triangles.size() / 3);
 
-		Center* c1 = GetCenter(posCenter0);
-		if (c1 == nullptr)
-		{
-			c1 = new Center(centerIndex++, posCenter0);
-			m_centers.push_back(c1);
-			AddCenter(c1);
-		}
+	// Center of each site, created the first time a triangle uses the site
+	std::vector<Center*> siteCenters(points.size(), nullptr);
+	// Edge of each half-edge, once its triangle has been visited
+	std::vector<Edge*> halfEdgeEdges(triangles.size(), nullptr);
 
-		Center* c2 = GetCenter(posCenter1);
-		if (c2 == nullptr)
+	auto getCenter = [this, &points, &siteCenters, &centerIndex](unsigned int site)
+	{
+		if (siteCenters[site] == nullptr)
 		{
-			c2 = new Center(centerIndex++, posCenter1);
-			m_centers.push_back(c2);
-			AddCenter(c2);
+			Vector2 position(points[site].GetX(), points[site].GetY());
+			siteCenters[site] = m_arena.New<Center>(centerIndex++, position, &m_arena);
+			m_centers.push_back(siteCenters[site]);
 		}
 
-		Center* c3 = GetCenter(posCenter2);
-		if (c3 == nullptr)
-		{
-			c3 = new Center(centerIndex++, posCenter2);
-			m_centers.push_back(c3);
-			AddCenter(c3);
-		}
+		return siteCenters[site];
+	};
 
-		Corner* c = new Corner(cornerIndex++, Vector2());
+	for (size_t t = 0; t < triangles.size(); t += 3)
+	{
+		Center* c1 = getCenter(triangles[t]);
+		Center* c2 = getCenter(triangles[t + 1]);
+		Center* c3 = getCenter(triangles[t + 2]);
+
+		Corner* c = m_arena.New<Corner>(cornerIndex++, Vector2(), &m_arena);
 		m_corners.push_back(c);
 		c->m_centers.push_back(c1);
 		c->m_centers.push_back(c2);
@@ -655,50 +1040,34 @@ void Map::Triangulate(std::vector<DelaunayTriangulation::Vertex> points)
 		c3->m_corners.push_back(c);
 		c->m_position = c->CalculateCircumstanceCenter();
 
-		Edge* e12 = c1->GetEdgeWith(c2);
-		if (e12 == nullptr)
-		{
-			e12 = new Edge(edgeIndex++, c1, c2, nullptr, nullptr);
-			e12->m_v0 = c;
-			m_edges.push_back(e12);
-			c1->m_edges.push_back(e12);
-			c2->m_edges.push_back(e12);
-		}
-		else
-		{
-			e12->m_v1 = c;
-		}
-		c->m_edges.push_back(e12);
+		// An edge is created by the first of its two triangles and found by the second through the twin half-edge
+		Center* sites[3] = { c1, c2, c3 };
 
-		Edge* e23 = c2->GetEdgeWith(c3);
-		if (e23 == nullptr)
+		for (unsigned int k = 0; k < 3; ++k)
 		{
-			e23 = new Edge(edgeIndex++, c2, c3, nullptr, nullptr);
-			e23->m_v0 = c;
-			m_edges.push_back(e23);
-			c2->m_edges.push_back(e23);
-			c3->m_edges.push_back(e23);
-		}
-		else
-		{
-			e23->m_v1 = c;
-		}
-		c->m_edges.push_back(e23);
+			unsigned int halfEdge = static_cast<unsigned int>(t) + k;
+			unsigned int twin = halfEdges[halfEdge];
+			Edge* e = twin != DelaunayTriangulation::NO_HALF_EDGE ? halfEdgeEdges[twin] : nullptr;
 
-		Edge* e31 = c3->GetEdgeWith(c1);
-		if (e31 == nullptr)
-		{
-			e31 = new Edge(edgeIndex++, c3, c1, nullptr, nullptr);
-			e31->m_v0 = c;
-			m_edges.push_back(e31);
-			c3->m_edges.push_back(e31);
-			c1->m_edges.push_back(e31);
-		}
-		else
-		{
-			e31->m_v1 = c;
+			if (e == nullptr)
+			{
+				Center* d0 = sites[k];
+				Center* d1 = sites[(k + 1) % 3];
+
+				e = m_arena.New<Edge>(edgeIndex++, d0, d1, nullptr, nullptr);
+				e->m_v0 = c;
+				m_edges.push_back(e);
+				d0->m_edges.push_back(e);
+				d1->m_edges.push_back(e);
+			}
+			else
+			{
+				e->m_v1 = c;
+			}
+
+			halfEdgeEdges[halfEdge] = e;
+			c->m_edges.push_back(e);
 		}
-		c->m_edges.push_back(e31);
 	}
 }
 
@@ -734,60 +1103,36 @@ void Map::FinishInfo()
 	}
 }
 
-void Map::AddCenter(Center* c)
+void Map::ToCenters(const std::vector<unsigned int>& indices, std::vector<Center*>& centers) const
 {
-	std::map<double, std::map<double, Center*>>::const_iterator iter = m_posCenterMap.find(c->m_position.x);
+	centers.resize(indices.size());
 
-	if (iter != m_posCenterMap.end())
+	for (size_t i = 0; i < indices.size(); ++i)
 	{
-		m_posCenterMap[static_cast<int>(c->m_position.x)][static_cast<int>(c->m_position.y)] = c;
-	}
-	else
-	{
-		m_posCenterMap[static_cast<int>(c->m_position.x)] = std::map<double, Center*>();
-		m_posCenterMap[static_cast<int>(c->m_position.x)][static_cast<int>(c->m_position.y)] = c;
+		centers[i] = m_centers[indices[i]];
 	}
 }
 
-Center* Map::GetCenter(Vector2 position)
+void Map::GetLandCorners(std::vector<unsigned int>& landCorners) const
 {
-	std::map<double, std::map<double, Center*>>::const_iterator iter = m_posCenterMap.find(position.x);
+	landCorners.clear();
 
-	if (iter != m_posCenterMap.end())
+	for (unsigned int c = 0; c < m_mesh.GetCornerCount(); ++c)
 	{
-		std::map<double, Center*>::const_iterator iter2 = iter->second.find(position.y);
-
-		if (iter2 != iter->second.end())
-		{
-			return iter2->second;
-		}
-	}
-
-	return nullptr;
-}
-
-std::vector<Corner*> Map::GetLandCorners()
-{
-	std::vector<Corner*> landCorners;
-
-	for (auto c : m_corners)
-	{
-		if (!c->m_water)
+		if (!m_attributes.m_corners.m_water.Test(c))
 		{
 			landCorners.push_back(c);
 		}
 	}
-
-	return landCorners;
 }
 
-std::vector<Corner*> Map::GetLakeCorners()
+std::vector<unsigned int> Map::GetLakeCorners() const
 {
-	std::vector<Corner*> lakeCorners;
+	std::vector<unsigned int> lakeCorners;
 
-	for (auto c : m_corners)
+	for (unsigned int c = 0; c < m_mesh.GetCornerCount(); ++c)
 	{
-		if (!c->m_water && !c->m_ocean)
+		if (!m_attributes.m_corners.m_water.Test(c) && !m_attributes.m_corners.m_ocean.Test(c))
 		{
 			lakeCorners.push_back(c);
 		}
@@ -869,12 +1214,14 @@ std::string Map::CreateSeed(int length) const
 
 unsigned int Map::HashString(std::string seed)
 {
-	unsigned int hash = 0;
+	// 32-bit FNV-1a, identical on every platform and compiler
+	unsigned int hash = 2166136261u;
 
 	for (size_t i = 0; i < seed.length(); ++i)
 	{
-		hash += static_cast<unsigned int>(static_cast<int>(seed[i]) * pow(2, i));
+		hash ^= static_cast<unsigned char>(seed[i]);
+		hash *= 16777619u;
 	}
 
-	return hash % UINT_MAX;
+	return hash;
 }
\ No newline at end of file
@@ -2,11 +2,22 @@
 #define MAP_H
 
 #include <vector>
-#include <map>
+#include <memory>
+#include <string>
+#include <cstdint>
 
+#include "Arena.h"
+#include "Attributes.h"
+#include "CenterGrid.h"
 #include "DelaunayTriangulation.h"
+#include "MapWorkspace.h"
+#include "LinearQuadTree.h"
+#include "MapInstrumentation.h"
+#include "Mesh.h"
 #include "Structure.h"
-#include "QuadTree.h"
+#include "Span.h"
+#include "TaskGraph.h"
+#include "ThreadPool.h"
 
 // Forward Declaration
 class Vector2;
@@ -18,6 +29,56 @@ namespace noise
 	}
 }
 
+// Tunable constants of the attribute stages.
+// Changing them with Map::SetParameters only reruns the stages that depend on them on the next Generate().
+struct MapParameters
+{
+	MapParameters() :
+		m_landMargin(0.075), m_landFalloff(0.3), m_elevationScale(1.05),
+		m_centersPerRiver(3.0), m_riverMinElevation(0.3), m_riverMaxElevation(0.9),
+		m_riverMoisture(0.2), m_maxRiverMoisture(3.0), m_freshwaterMoistureDecay(0.9), m_oceanMoistureDecay(0.3),
+		m_hillElevation(0.3), m_mountainElevation(0.6), m_snowElevation(0.85), m_beachMoisture(0.6) { }
+
+	~MapParameters() = default;
+
+	MapParameters(const MapParameters& parameters) = default;
+	MapParameters(MapParameters&& parameters) = default;
+
+	MapParameters& operator=(const MapParameters& parameters) = default;
+	MapParameters& operator=(MapParameters&& parameters) = default;
+
+	// Land: share of the map kept as ocean along every side, and how fast land thins out away from the middle
+	double m_landMargin;
+	double m_landFalloff;
+
+	// Elevation: shape of the redistribution curve, higher values give more lowlands
+	double m_elevationScale;
+
+	// Rivers: one river source is tried per m_centersPerRiver centers, in the given elevation band
+	double m_centersPerRiver;
+	double m_riverMinElevation;
+	double m_riverMaxElevation;
+
+	// Moisture: per unit of river volume and at most, then the decay per corner away from fresh water and from the ocean
+	double m_riverMoisture;
+	double m_maxRiverMoisture;
+	double m_freshwaterMoistureDecay;
+	double m_oceanMoistureDecay;
+
+	// Biomes: lowest elevation of every elevation band, and the moisture under which coasts are beaches
+	double m_hillElevation;
+	double m_mountainElevation;
+	double m_snowElevation;
+	double m_beachMoisture;
+};
+
+// Duration of one generation stage, in milliseconds
+struct MapStageTime
+{
+	std::string m_name;
+	double m_time;
+};
+
 class Map
 {
 public:
@@ -32,6 +93,8 @@ public:
 	Map& operator=(const Map& map) = delete;
 	Map& operator=(Map&& map) = delete;
 
+	// Runs the stages whose parameters changed since the last call, and the stages depending on them.
+	// The first call runs everything.
 	void Generate();
 
 	void GeneratePolygons();
@@ -40,28 +103,106 @@ public:
 	std::vector<Edge*> GetEdges() const;
 	std::vector<Corner*> GetCorners() const;
 	std::vector<Center*> GetCenters() const;
-
-	Center* GetCenterAt(Vector2 pos);
+	const Mesh& GetMesh() const;
+	const MapAttributes& GetAttributes() const;
+	int GetWidth() const;
+	int GetHeight() const;
+
+	// Hash of the generated graph and attributes, equal for equal seeds and parameters
+	uint64_t GetGraphHash() const;
+	static uint64_t HashGraph(const Mesh& mesh, const MapAttributes& attributes);
+
+	// Writes the mesh and attributes in the MapFile binary format
+	bool Save(const std::string& path) const;
+
+	// Center whose polygon holds pos, nullptr outside the map
+	Center* GetCenterAt(Vector2 pos) const;
+	// GetCenterAt for every position, centers must be as long as positions.
+	// Large batches are bucketed by grid row before the lookups, see CenterGrid::FindCenters.
+	void GetCentersAt(Span<const Vector2> positions, Span<Center*> centers) const;
+
+	// Queries over the center quadtree, centers is filled and keeps its capacity for the next query.
+	// Centers whose polygon bounding box intersects range
+	void GetCentersInRange(const AABB& range, std::vector<Center*>& centers) const;
+	// Centers whose position is within radius of pos
+	void GetCentersInRadius(Vector2 pos, double radius, std::vector<Center*>& centers) const;
+	// The count centers closest to pos, closest first
+	void GetNearestCenters(Vector2 pos, unsigned int count, std::vector<Center*>& centers) const;
+
+	DelaunayTriangulation::Algorithm GetTriangulationAlgorithm() const;
+	void SetTriangulationAlgorithm(DelaunayTriangulation::Algorithm algorithm);
+
+	const MapParameters& GetParameters() const;
+	void SetParameters(const MapParameters& parameters);
+
+	// Threads used by the generation stages, 0 for one per hardware thread
+	unsigned int GetThreadCount() const;
+	void SetThreadCount(unsigned int threadCount);
+
+	// Runs the stages on a pool shared with other maps instead of an own one, nullptr to go back to an own pool
+	void SetThreadPool(ThreadPool* threadPool);
+	// Takes the noise module and scratch buffers from a workspace, nullptr to go back to an own workspace
+	void SetWorkspace(MapWorkspace* workspace);
+
+	// Stages run by the last Generate() in pipeline order, stages of the task graph overlap when it runs on several threads
+	const std::vector<MapStageTime>& GetStageTimes() const;
+
+	// Receives the stage events and counters of Generate(), nullptr for none.
+	// The instrumentation is not owned and must outlive the generation.
+	MapInstrumentation* GetInstrumentation() const;
+	void SetInstrumentation(MapInstrumentation* instrumentation);
+
+	// Prints the seed to stdout, disabled by default. Stage timings go through SetInstrumentation.
+	bool IsVerbose() const;
+	void SetVerbose(bool verbose);
+
+	// Biome of a polygon from its flags, elevation and moisture
+	static BiomeType GetBiome(bool ocean, bool water, bool coast, double elevation, double moisture, const MapParameters& parameters);
+	// 32-bit FNV-1a of a seed string, identical on every platform and compiler
+	static unsigned int HashString(std::string seed);
 
 private:
 	int m_mapWidth;
 	int m_mapHeight;
 	double m_pointSpread;
 	double m_zCoord;
+	unsigned int m_pointSeed;
+	unsigned int m_noiseSeed;
+	unsigned int m_riverSeed;
 	noise::module::Perlin* m_noiseMap;
 	std::string m_seed;
-	QuadTree<Center*> m_centersQuadTree;
+	MapParameters m_parameters;
+	// Channels whose producing stages rerun on the next Generate(), all of them before the first one
+	TaskGraph::ChannelMask m_staleChannels;
+	DelaunayTriangulation::Algorithm m_triangulationAlgorithm;
+	unsigned int m_threadCount;
+	bool m_verbose;
+	ThreadPool* m_threadPool;
+	std::unique_ptr<ThreadPool> m_ownedThreadPool;
+	MapWorkspace* m_workspace;
+	std::unique_ptr<MapWorkspace> m_ownedWorkspace;
+	std::vector<MapStageTime> m_stageTimes;
+	MapInstrumentation* m_instrumentation;
+	LinearQuadTree m_centersQuadTree;
+	CenterGrid m_centerGrid;
 
 	std::vector<DelaunayTriangulation::Vertex> m_points;
 
-	std::map<double, std::map<double, Center*>> m_posCenterMap;
+	// Owns the Center, Corner and Edge nodes and their adjacency lists
+	Arena m_arena;
 	std::vector<Edge*> m_edges;
 	std::vector<Corner*> m_corners;
 	std::vector<Center*> m_centers;
+	Mesh m_mesh;
+	MapAttributes m_attributes;
 
 	static const std::vector<std::vector<BiomeType>> m_elevationMoistureMatrix;
 	static std::vector<std::vector<BiomeType>> MakeBiomeMatrix();
 
+	// Runs one stage between the instrumentation events, returns its duration in milliseconds
+	double RunStage(const std::string& name, const std::function<void()>& function);
+	void Count(MapCounter counter, uint64_t value);
+
 	bool IsIsland(Vector2 position) const;
 	void CalculateDownslopes();
 	void GenerateRivers();
@@ -73,19 +214,21 @@ private:
 	void AssignCornerMoisture();
 	void AssignPolygonMoisture();
 	void AssignBiomes();
+	void PopulateQuadTree();
+	void BuildCenterGrid();
+
+	ThreadPool& GetThreadPool();
+	MapWorkspace& GetWorkspace();
 
 	void GeneratePoints();
 	void Triangulate(std::vector<DelaunayTriangulation::Vertex> points);
 	void FinishInfo();
-	void AddCenter(Center* c);
-	Center* GetCenter(Vector2 position);
 
-	std::vector<Corner*> GetLandCorners();
-	std::vector<Corner*> GetLakeCorners();
+	void ToCenters(const std::vector<unsigned int>& indices, std::vector<Center*>& centers) const;
+	void GetLandCorners(std::vector<unsigned int>& landCorners) const;
+	std::vector<unsigned int> GetLakeCorners() const;
 	void LloydRelaxation();
 	std::string CreateSeed(int length) const;
-
-	static unsigned int HashString(std::string seed);
 };
 
 #endif
\ No newline at end of file
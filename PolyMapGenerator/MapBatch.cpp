@@ -0,0 +1,83 @@
+#include <atomic>
+#include <algorithm>
+
+#include "MapBatch.h"
+#include "Map.h"
+
+MapBatch::MapBatch(unsigned int threadCount) : m_threadPool(threadCount)
+{
+
+}
+
+MapBatch::~MapBatch() = default;
+
+void MapBatch::Generate(const std::vector<MapRequest>& requests, const Callback& callback)
+{
+	TaskGroup group;
+	std::atomic<size_t> nextRequest(0);
+
+	// One task per thread, each taking the next request once its map is done,
+	// so that no more maps and workspaces are alive than there are threads
+	size_t taskCount = std::min(requests.size(), static_cast<size_t>(m_threadPool.GetThreadCount()));
+
+	for (size_t t = 0; t < taskCount; ++t)
+	{
+		m_threadPool.Submit(group, [this, &requests, &callback, &nextRequest]()
+		{
+			for (size_t i = nextRequest.fetch_add(1); i < requests.size(); i = nextRequest.fetch_add(1))
+			{
+				const MapRequest& request = requests[i];
+				MapWorkspace* workspace = AcquireWorkspace();
+
+				std::unique_ptr<Map> map(new Map(request.m_width, request.m_height, request.m_pointSpread, request.m_seed));
+				map->SetThreadPool(&m_threadPool);
+				map->SetWorkspace(workspace);
+				map->Generate();
+
+				// The map must not keep references to the batch once it is handed out
+				map->SetThreadPool(nullptr);
+				map->SetWorkspace(nullptr);
+				ReleaseWorkspace(workspace);
+
+				std::lock_guard<std::mutex> lock(m_callbackMutex);
+				callback(i, std::move(map));
+			}
+		});
+	}
+
+	m_threadPool.Wait(group);
+}
+
+unsigned int MapBatch::GetThreadCount() const
+{
+	return m_threadPool.GetThreadCount();
+}
+
+size_t MapBatch::GetWorkspaceCount()
+{
+	std::lock_guard<std::mutex> lock(m_workspaceMutex);
+
+	return m_workspaces.size();
+}
+
+MapWorkspace* MapBatch::AcquireWorkspace()
+{
+	std::lock_guard<std::mutex> lock(m_workspaceMutex);
+
+	if (m_freeWorkspaces.empty())
+	{
+		m_workspaces.push_back(std::unique_ptr<MapWorkspace>(new MapWorkspace()));
+		return m_workspaces.back().get();
+	}
+
+	MapWorkspace* workspace = m_freeWorkspaces.back();
+	m_freeWorkspaces.pop_back();
+
+	return workspace;
+}
+
+void MapBatch::ReleaseWorkspace(MapWorkspace* workspace)
+{
+	std::lock_guard<std::mutex> lock(m_workspaceMutex);
+	m_freeWorkspaces.push_back(workspace);
+}
\ No newline at end of file
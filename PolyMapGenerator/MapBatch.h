@@ -0,0 +1,65 @@
+#ifndef MAP_BATCH_H
+#define MAP_BATCH_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <mutex>
+#include <functional>
+
+#include "MapWorkspace.h"
+#include "ThreadPool.h"
+
+// Forward Declaration
+class Map;
+
+struct MapRequest
+{
+	int m_width;
+	int m_height;
+	double m_pointSpread;
+	std::string m_seed;
+};
+
+// Generates many maps concurrently on one shared thread pool.
+// Every running map borrows a workspace (noise module and scratch buffers) that is returned
+// and reused by the next map.
+class MapBatch
+{
+public:
+	// Receives the index of the request and the generated map.
+	// Called from the pool threads, one call at a time.
+	typedef std::function<void(size_t index, std::unique_ptr<Map> map)> Callback;
+
+	// 0 uses one thread per hardware thread
+	explicit MapBatch(unsigned int threadCount = 0);
+
+	~MapBatch();
+
+	MapBatch(const MapBatch& batch) = delete;
+	MapBatch(MapBatch&& batch) = delete;
+
+	MapBatch& operator=(const MapBatch& batch) = delete;
+	MapBatch& operator=(MapBatch&& batch) = delete;
+
+	// Returns once every map has been generated and passed to the callback
+	void Generate(const std::vector<MapRequest>& requests, const Callback& callback);
+
+	unsigned int GetThreadCount() const;
+	// Workspaces created so far, at most one per thread
+	size_t GetWorkspaceCount();
+
+private:
+	MapWorkspace* AcquireWorkspace();
+	void ReleaseWorkspace(MapWorkspace* workspace);
+
+	ThreadPool m_threadPool;
+
+	std::mutex m_workspaceMutex;
+	std::vector<std::unique_ptr<MapWorkspace>> m_workspaces;
+	std::vector<MapWorkspace*> m_freeWorkspaces;
+
+	std::mutex m_callbackMutex;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,625 @@
+#include "MapFile.h"
+#include "Attributes.h"
+#include "Mesh.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	const char MAGIC[4] = { 'P', 'M', 'A', 'P' };
+	const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+	struct SectionData
+	{
+		MapFileSection m_id;
+		uint32_t m_elementSize;
+		uint64_t m_count;
+		const void* m_data;
+	};
+
+	template <typename T>
+	SectionData MakeSection(MapFileSection id, const std::vector<T>& data)
+	{
+		return SectionData{ id, static_cast<uint32_t>(sizeof(T)), data.size(), data.data() };
+	}
+
+	SectionData MakeSection(MapFileSection id, const BitSet& flags)
+	{
+		return SectionData{ id, static_cast<uint32_t>(sizeof(uint64_t)), flags.GetWordCount(), flags.GetWords() };
+	}
+
+	uint64_t AlignOffset(uint64_t offset)
+	{
+		return (offset + 7) & ~static_cast<uint64_t>(7);
+	}
+
+	// Element size and count a section must have in a file with the counts of header
+	struct SectionLayout
+	{
+		uint32_t m_elementSize;
+		uint64_t m_count;
+	};
+
+	uint64_t GetWordCount(uint32_t bitCount)
+	{
+		return (static_cast<uint64_t>(bitCount) + 63) / 64;
+	}
+
+	SectionLayout GetSectionLayout(MapFileSection section, const MapFileHeader& header)
+	{
+		const uint64_t centerCount = header.m_centerCount;
+		const uint64_t cornerCount = header.m_cornerCount;
+		const uint64_t edgeCount = header.m_edgeCount;
+
+		switch (section)
+		{
+		case MapFileSection::CenterPositions:
+			return SectionLayout{ sizeof(MapFilePoint), centerCount };
+		case MapFileSection::CornerPositions:
+			return SectionLayout{ sizeof(MapFilePoint), cornerCount };
+
+		case MapFileSection::CenterCentersOffsets:
+		case MapFileSection::CenterCornersOffsets:
+		case MapFileSection::CenterEdgesOffsets:
+			return SectionLayout{ sizeof(uint32_t), centerCount + 1 };
+		case MapFileSection::CornerCornersOffsets:
+		case MapFileSection::CornerCentersOffsets:
+		case MapFileSection::CornerEdgesOffsets:
+			return SectionLayout{ sizeof(uint32_t), cornerCount + 1 };
+
+		case MapFileSection::EdgeCenters:
+		case MapFileSection::EdgeCorners:
+			return SectionLayout{ sizeof(uint32_t), 2 * edgeCount };
+
+		case MapFileSection::CenterElevation:
+		case MapFileSection::CenterMoisture:
+			return SectionLayout{ sizeof(double), centerCount };
+		case MapFileSection::CenterBiome:
+			return SectionLayout{ sizeof(uint8_t), centerCount };
+		case MapFileSection::CenterWater:
+		case MapFileSection::CenterOcean:
+		case MapFileSection::CenterCoast:
+		case MapFileSection::CenterBorder:
+			return SectionLayout{ sizeof(uint64_t), GetWordCount(header.m_centerCount) };
+
+		case MapFileSection::CornerElevation:
+		case MapFileSection::CornerMoisture:
+		case MapFileSection::CornerRiverVolume:
+			return SectionLayout{ sizeof(double), cornerCount };
+		case MapFileSection::CornerDownslope:
+		case MapFileSection::CornerDownslopeEdge:
+			return SectionLayout{ sizeof(uint32_t), cornerCount };
+		case MapFileSection::CornerWater:
+		case MapFileSection::CornerOcean:
+		case MapFileSection::CornerCoast:
+		case MapFileSection::CornerBorder:
+			return SectionLayout{ sizeof(uint64_t), GetWordCount(header.m_cornerCount) };
+
+		case MapFileSection::EdgeRiverVolume:
+			return SectionLayout{ sizeof(double), edgeCount };
+
+		default:
+			// The counts of the indices sections are checked against their offsets
+			return SectionLayout{ sizeof(uint32_t), 0 };
+		}
+	}
+
+	bool IsIndicesSection(MapFileSection section)
+	{
+		switch (section)
+		{
+		case MapFileSection::CenterCentersIndices:
+		case MapFileSection::CenterCornersIndices:
+		case MapFileSection::CenterEdgesIndices:
+		case MapFileSection::CornerCornersIndices:
+		case MapFileSection::CornerCentersIndices:
+		case MapFileSection::CornerEdgesIndices:
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	std::vector<MapFilePoint> ToPoints(const std::vector<Vector2>& positions)
+	{
+		std::vector<MapFilePoint> points(positions.size());
+
+		for (size_t i = 0; i < positions.size(); ++i)
+		{
+			points[i].x = positions[i].x;
+			points[i].y = positions[i].y;
+		}
+
+		return points;
+	}
+}
+
+const uint32_t MapFile::VERSION;
+
+#ifdef _WIN32
+MapFile::MapFile() : m_data(nullptr), m_size(0), m_sections(nullptr), m_file(INVALID_HANDLE_VALUE), m_mapping(nullptr)
+{
+
+}
+#else
+MapFile::MapFile() : m_data(nullptr), m_size(0), m_sections(nullptr), m_file(-1)
+{
+
+}
+#endif
+
+MapFile::~MapFile()
+{
+	Close();
+}
+
+bool MapFile::Write(const std::string& path, const Mesh& mesh, const MapAttributes& attributes, uint64_t graphHash)
+{
+	std::vector<MapFilePoint> centerPositions = ToPoints(mesh.m_centerPositions);
+	std::vector<MapFilePoint> cornerPositions = ToPoints(mesh.m_cornerPositions);
+
+	std::vector<uint8_t> biomes(attributes.m_centers.m_biome.size());
+	for (size_t i = 0; i < biomes.size(); ++i)
+	{
+		biomes[i] = static_cast<uint8_t>(attributes.m_centers.m_biome[i]);
+	}
+
+	const CenterAttributes& centers = attributes.m_centers;
+	const CornerAttributes& corners = attributes.m_corners;
+
+	const SectionData sections[] =
+	{
+		MakeSection(MapFileSection::CenterPositions, centerPositions),
+		MakeSection(MapFileSection::CornerPositions, cornerPositions),
+
+		MakeSection(MapFileSection::CenterCentersOffsets, mesh.m_centerCenters.m_offsets),
+		MakeSection(MapFileSection::CenterCentersIndices, mesh.m_centerCenters.m_indices),
+		MakeSection(MapFileSection::CenterCornersOffsets, mesh.m_centerCorners.m_offsets),
+		MakeSection(MapFileSection::CenterCornersIndices, mesh.m_centerCorners.m_indices),
+		MakeSection(MapFileSection::CenterEdgesOffsets, mesh.m_centerEdges.m_offsets),
+		MakeSection(MapFileSection::CenterEdgesIndices, mesh.m_centerEdges.m_indices),
+
+		MakeSection(MapFileSection::CornerCornersOffsets, mesh.m_cornerCorners.m_offsets),
+		MakeSection(MapFileSection::CornerCornersIndices, mesh.m_cornerCorners.m_indices),
+		MakeSection(MapFileSection::CornerCentersOffsets, mesh.m_cornerCenters.m_offsets),
+		MakeSection(MapFileSection::CornerCentersIndices, mesh.m_cornerCenters.m_indices),
+		MakeSection(MapFileSection::CornerEdgesOffsets, mesh.m_cornerEdges.m_offsets),
+		MakeSection(MapFileSection::CornerEdgesIndices, mesh.m_cornerEdges.m_indices),
+
+		MakeSection(MapFileSection::EdgeCenters, mesh.m_edgeCenters),
+		MakeSection(MapFileSection::EdgeCorners, mesh.m_edgeCorners),
+
+		MakeSection(MapFileSection::CenterElevation, centers.m_elevation),
+		MakeSection(MapFileSection::CenterMoisture, centers.m_moisture),
+		MakeSection(MapFileSection::CenterBiome, biomes),
+		MakeSection(MapFileSection::CenterWater, centers.m_water),
+		MakeSection(MapFileSection::CenterOcean, centers.m_ocean),
+		MakeSection(MapFileSection::CenterCoast, centers.m_coast),
+		MakeSection(MapFileSection::CenterBorder, centers.m_border),
+
+		MakeSection(MapFileSection::CornerElevation, corners.m_elevation),
+		MakeSection(MapFileSection::CornerMoisture, corners.m_moisture),
+		MakeSection(MapFileSection::CornerRiverVolume, corners.m_riverVolume),
+		MakeSection(MapFileSection::CornerDownslope, corners.m_downslope),
+		MakeSection(MapFileSection::CornerDownslopeEdge, corners.m_downslopeEdge),
+		MakeSection(MapFileSection::CornerWater, corners.m_water),
+		MakeSection(MapFileSection::CornerOcean, corners.m_ocean),
+		MakeSection(MapFileSection::CornerCoast, corners.m_coast),
+		MakeSection(MapFileSection::CornerBorder, corners.m_border),
+
+		MakeSection(MapFileSection::EdgeRiverVolume, attributes.m_edges.m_riverVolume)
+	};
+
+	const uint32_t sectionCount = static_cast<uint32_t>(MapFileSection::Size);
+	static_assert(sizeof(sections) / sizeof(sections[0]) == static_cast<size_t>(MapFileSection::Size), "Every section must be written");
+
+	MapFileHeader header;
+	memcpy(header.m_magic, MAGIC, sizeof(MAGIC));
+	header.m_version = VERSION;
+	header.m_byteOrder = BYTE_ORDER_MARK;
+	header.m_sectionCount = sectionCount;
+	header.m_centerCount = mesh.GetCenterCount();
+	header.m_cornerCount = mesh.GetCornerCount();
+	header.m_edgeCount = mesh.GetEdgeCount();
+	header.m_reserved = 0;
+	header.m_graphHash = graphHash;
+
+	std::vector<MapFileSectionEntry> entries(sectionCount);
+	uint64_t offset = AlignOffset(sizeof(MapFileHeader) + sectionCount * sizeof(MapFileSectionEntry));
+
+	for (uint32_t i = 0; i < sectionCount; ++i)
+	{
+		entries[i].m_id = static_cast<uint32_t>(sections[i].m_id);
+		entries[i].m_elementSize = sections[i].m_elementSize;
+		entries[i].m_count = sections[i].m_count;
+		entries[i].m_offset = offset;
+
+		offset = AlignOffset(offset + sections[i].m_elementSize * sections[i].m_count);
+	}
+
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+	{
+		return false;
+	}
+
+	const char padding[8] = { 0 };
+	uint64_t written = 0;
+
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(MapFileSectionEntry));
+	written = sizeof(header) + entries.size() * sizeof(MapFileSectionEntry);
+
+	for (uint32_t i = 0; i < sectionCount; ++i)
+	{
+		file.write(padding, entries[i].m_offset - written);
+		file.write(static_cast<const char*>(sections[i].m_data), sections[i].m_elementSize * sections[i].m_count);
+		written = entries[i].m_offset + sections[i].m_elementSize * sections[i].m_count;
+	}
+
+	file.write(padding, offset - written);
+
+	return static_cast<bool>(file);
+}
+
+bool MapFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	m_file = file;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+	m_size = static_cast<size_t>(fileSize.QuadPart);
+#else
+	m_file = open(path.c_str(), O_RDONLY);
+	if (m_file < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(m_file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		Close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, m_file, 0);
+	m_data = data != MAP_FAILED ? static_cast<const unsigned char*>(data) : nullptr;
+	m_size = static_cast<size_t>(fileStat.st_size);
+#endif
+
+	if (m_data == nullptr || m_size < sizeof(MapFileHeader))
+	{
+		Close();
+		return false;
+	}
+
+	const MapFileHeader& header = GetHeader();
+	if (memcmp(header.m_magic, MAGIC, sizeof(MAGIC)) != 0 || header.m_version != VERSION ||
+		header.m_byteOrder != BYTE_ORDER_MARK || header.m_sectionCount != static_cast<uint32_t>(MapFileSection::Size) ||
+		m_size < sizeof(MapFileHeader) + header.m_sectionCount * sizeof(MapFileSectionEntry))
+	{
+		Close();
+		return false;
+	}
+
+	m_sections = reinterpret_cast<const MapFileSectionEntry*>(m_data + sizeof(MapFileHeader));
+
+	for (uint32_t i = 0; i < header.m_sectionCount; ++i)
+	{
+		const MapFileSectionEntry& entry = m_sections[i];
+
+		if (entry.m_id != i || entry.m_offset % 8 != 0 || entry.m_offset > m_size ||
+			(entry.m_elementSize != 0 && entry.m_count > (m_size - entry.m_offset) / entry.m_elementSize))
+		{
+			Close();
+			return false;
+		}
+	}
+
+	if (!Validate())
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void MapFile::Close()
+{
+#ifdef _WIN32
+	if (m_data != nullptr)
+	{
+		UnmapViewOfFile(m_data);
+	}
+
+	if (m_mapping != nullptr)
+	{
+		CloseHandle(m_mapping);
+		m_mapping = nullptr;
+	}
+
+	if (m_file != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_file);
+		m_file = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_data != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(m_data), m_size);
+	}
+
+	if (m_file >= 0)
+	{
+		close(m_file);
+		m_file = -1;
+	}
+#endif
+
+	m_data = nullptr;
+	m_size = 0;
+	m_sections = nullptr;
+}
+
+bool MapFile::IsOpen() const
+{
+	return m_data != nullptr;
+}
+
+const MapFileHeader& MapFile::GetHeader() const
+{
+	return *reinterpret_cast<const MapFileHeader*>(m_data);
+}
+
+Span<const MapFilePoint> MapFile::GetCenterPositions() const
+{
+	return GetSection<MapFilePoint>(MapFileSection::CenterPositions);
+}
+
+Span<const MapFilePoint> MapFile::GetCornerPositions() const
+{
+	return GetSection<MapFilePoint>(MapFileSection::CornerPositions);
+}
+
+MapFileAdjacency MapFile::GetCenterCenters() const
+{
+	return GetAdjacency(MapFileSection::CenterCentersOffsets, MapFileSection::CenterCentersIndices);
+}
+
+MapFileAdjacency MapFile::GetCenterCorners() const
+{
+	return GetAdjacency(MapFileSection::CenterCornersOffsets, MapFileSection::CenterCornersIndices);
+}
+
+MapFileAdjacency MapFile::GetCenterEdges() const
+{
+	return GetAdjacency(MapFileSection::CenterEdgesOffsets, MapFileSection::CenterEdgesIndices);
+}
+
+MapFileAdjacency MapFile::GetCornerCorners() const
+{
+	return GetAdjacency(MapFileSection::CornerCornersOffsets, MapFileSection::CornerCornersIndices);
+}
+
+MapFileAdjacency MapFile::GetCornerCenters() const
+{
+	return GetAdjacency(MapFileSection::CornerCentersOffsets, MapFileSection::CornerCentersIndices);
+}
+
+MapFileAdjacency MapFile::GetCornerEdges() const
+{
+	return GetAdjacency(MapFileSection::CornerEdgesOffsets, MapFileSection::CornerEdgesIndices);
+}
+
+Span<const uint32_t> MapFile::GetEdgeCenters() const
+{
+	return GetSection<uint32_t>(MapFileSection::EdgeCenters);
+}
+
+Span<const uint32_t> MapFile::GetEdgeCorners() const
+{
+	return GetSection<uint32_t>(MapFileSection::EdgeCorners);
+}
+
+Span<const double> MapFile::GetCenterElevations() const
+{
+	return GetSection<double>(MapFileSection::CenterElevation);
+}
+
+Span<const double> MapFile::GetCenterMoistures() const
+{
+	return GetSection<double>(MapFileSection::CenterMoisture);
+}
+
+BiomeType MapFile::GetCenterBiome(uint32_t i) const
+{
+	return static_cast<BiomeType>(GetSection<uint8_t>(MapFileSection::CenterBiome)[i]);
+}
+
+MapFileFlags MapFile::GetCenterFlags(MapFileSection section) const
+{
+	MapFileFlags flags;
+	flags.m_words = GetSection<uint64_t>(section);
+
+	return flags;
+}
+
+Span<const double> MapFile::GetCornerElevations() const
+{
+	return GetSection<double>(MapFileSection::CornerElevation);
+}
+
+Span<const double> MapFile::GetCornerMoistures() const
+{
+	return GetSection<double>(MapFileSection::CornerMoisture);
+}
+
+Span<const double> MapFile::GetCornerRiverVolumes() const
+{
+	return GetSection<double>(MapFileSection::CornerRiverVolume);
+}
+
+Span<const uint32_t> MapFile::GetCornerDownslopes() const
+{
+	return GetSection<uint32_t>(MapFileSection::CornerDownslope);
+}
+
+Span<const uint32_t> MapFile::GetCornerDownslopeEdges() const
+{
+	return GetSection<uint32_t>(MapFileSection::CornerDownslopeEdge);
+}
+
+MapFileFlags MapFile::GetCornerFlags(MapFileSection section) const
+{
+	MapFileFlags flags;
+	flags.m_words = GetSection<uint64_t>(section);
+
+	return flags;
+}
+
+Span<const double> MapFile::GetEdgeRiverVolumes() const
+{
+	return GetSection<double>(MapFileSection::EdgeRiverVolume);
+}
+
+template <typename T>
+Span<const T> MapFile::GetSection(MapFileSection section) const
+{
+	const MapFileSectionEntry& entry = m_sections[static_cast<uint32_t>(section)];
+
+	if (entry.m_elementSize != sizeof(T))
+	{
+		return Span<const T>();
+	}
+
+	return Span<const T>(reinterpret_cast<const T*>(m_data + entry.m_offset), static_cast<size_t>(entry.m_count));
+}
+
+MapFileAdjacency MapFile::GetAdjacency(MapFileSection offsets, MapFileSection indices) const
+{
+	MapFileAdjacency adjacency;
+	adjacency.m_offsets = GetSection<uint32_t>(offsets);
+	adjacency.m_indices = GetSection<uint32_t>(indices);
+
+	return adjacency;
+}
+
+bool MapFile::Validate() const
+{
+	const MapFileHeader& header = GetHeader();
+
+	for (uint32_t i = 0; i < header.m_sectionCount; ++i)
+	{
+		MapFileSection section = static_cast<MapFileSection>(i);
+		SectionLayout layout = GetSectionLayout(section, header);
+
+		if (m_sections[i].m_elementSize != layout.m_elementSize || (!IsIndicesSection(section) && m_sections[i].m_count != layout.m_count))
+		{
+			return false;
+		}
+	}
+
+	return ValidateAdjacency(MapFileSection::CenterCentersOffsets, MapFileSection::CenterCentersIndices, header.m_centerCount) &&
+		ValidateAdjacency(MapFileSection::CenterCornersOffsets, MapFileSection::CenterCornersIndices, header.m_cornerCount) &&
+		ValidateAdjacency(MapFileSection::CenterEdgesOffsets, MapFileSection::CenterEdgesIndices, header.m_edgeCount) &&
+		ValidateAdjacency(MapFileSection::CornerCornersOffsets, MapFileSection::CornerCornersIndices, header.m_cornerCount) &&
+		ValidateAdjacency(MapFileSection::CornerCentersOffsets, MapFileSection::CornerCentersIndices, header.m_centerCount) &&
+		ValidateAdjacency(MapFileSection::CornerEdgesOffsets, MapFileSection::CornerEdgesIndices, header.m_edgeCount) &&
+		ValidateIndices(MapFileSection::EdgeCenters, header.m_centerCount) &&
+		ValidateIndices(MapFileSection::EdgeCorners, header.m_cornerCount) &&
+		ValidateIndices(MapFileSection::CornerDownslope, header.m_cornerCount) &&
+		ValidateIndices(MapFileSection::CornerDownslopeEdge, header.m_edgeCount) &&
+		ValidateBiomes();
+}
+
+bool MapFile::ValidateAdjacency(MapFileSection offsets, MapFileSection indices, uint32_t targetCount) const
+{
+	MapFileAdjacency adjacency = GetAdjacency(offsets, indices);
+
+	if (adjacency.m_offsets[0] != 0 || adjacency.m_offsets[adjacency.m_offsets.Size() - 1] != adjacency.m_indices.Size())
+	{
+		return false;
+	}
+
+	for (size_t i = 1; i < adjacency.m_offsets.Size(); ++i)
+	{
+		if (adjacency.m_offsets[i] < adjacency.m_offsets[i - 1])
+		{
+			return false;
+		}
+	}
+
+	for (uint32_t index : adjacency.m_indices)
+	{
+		if (index >= targetCount)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MapFile::ValidateBiomes() const
+{
+	// Biomes index per-biome tables, only BiomeType::None may lie past the real biomes
+	for (uint8_t biome : GetSection<uint8_t>(MapFileSection::CenterBiome))
+	{
+		if (biome >= static_cast<uint8_t>(BiomeType::Size) && biome != static_cast<uint8_t>(BiomeType::None))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool MapFile::ValidateIndices(MapFileSection section, uint32_t targetCount) const
+{
+	for (uint32_t index : GetSection<uint32_t>(section))
+	{
+		if (index >= targetCount && index != Mesh::INVALID_INDEX)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,223 @@
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+
+#include "MapInstrumentation.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+const char* GetCounterName(MapCounter counter)
+{
+	switch (counter)
+	{
+	case MapCounter::Points:
+		return "Points";
+	case MapCounter::Triangles:
+		return "Triangles";
+	case MapCounter::QueuePushes:
+		return "Queue pushes";
+	default:
+		return "Unknown";
+	}
+}
+
+size_t MapInstrumentation::GetPeakMemory()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS counters;
+
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+	{
+		return 0;
+	}
+
+	return counters.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+	{
+		return 0;
+	}
+
+#ifdef __APPLE__
+	return static_cast<size_t>(usage.ru_maxrss);
+#else
+	// Kilobytes on Linux
+	return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+MapChromeTrace::MapChromeTrace() : m_start(std::chrono::steady_clock::now())
+{
+	std::fill(m_counters, m_counters + static_cast<size_t>(MapCounter::Size), 0);
+}
+
+void MapChromeTrace::BeginStage(const std::string& name)
+{
+	AddEvent(name, 'B', 0);
+}
+
+void MapChromeTrace::EndStage(const std::string& name, double /*time*/)
+{
+	AddEvent(name, 'E', 0);
+}
+
+void MapChromeTrace::AddCount(MapCounter counter, uint64_t value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	uint64_t& total = m_counters[static_cast<size_t>(counter)];
+	total += value;
+
+	// Counter tracks show the running total, they are not tied to a thread
+	m_events.push_back({ GetCounterName(counter), 'C', GetTimestamp(), 0, total });
+}
+
+void MapChromeTrace::SetPeakMemory(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.push_back({ "Peak memory", 'C', GetTimestamp(), 0, bytes });
+}
+
+bool MapChromeTrace::Write(const std::string& path) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::ofstream file(path);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "{\"traceEvents\":[\n";
+
+	for (size_t i = 0; i < m_events.size(); ++i)
+	{
+		const Event& event = m_events[i];
+
+		file << "{\"name\":\"" << event.m_name << "\",\"ph\":\"" << event.m_phase << "\",\"ts\":" << std::fixed << std::setprecision(0)
+			<< event.m_timestamp << ",\"pid\":1,\"tid\":" << event.m_thread;
+
+		if (event.m_phase == 'C')
+		{
+			file << ",\"args\":{\"value\":" << event.m_value << "}";
+		}
+
+		file << "}" << (i + 1 < m_events.size() ? ",\n" : "\n");
+	}
+
+	file << "],\"displayTimeUnit\":\"ms\"}\n";
+
+	return file.good();
+}
+
+void MapChromeTrace::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_events.clear();
+	m_threads.clear();
+	std::fill(m_counters, m_counters + static_cast<size_t>(MapCounter::Size), 0);
+	m_start = std::chrono::steady_clock::now();
+}
+
+void MapChromeTrace::AddEvent(const std::string& name, char phase, uint64_t value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// Small thread numbers in the order the threads first show up, the trace viewer gives each one a row
+	std::thread::id id = std::this_thread::get_id();
+	auto thread = std::find(m_threads.begin(), m_threads.end(), id);
+
+	if (thread == m_threads.end())
+	{
+		thread = m_threads.insert(m_threads.end(), id);
+	}
+
+	unsigned int threadIndex = static_cast<unsigned int>(thread - m_threads.begin());
+
+	m_events.push_back({ name, phase, GetTimestamp(), threadIndex, value });
+}
+
+double MapChromeTrace::GetTimestamp() const
+{
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+MapSummaryTable::MapSummaryTable() : m_peakMemory(0)
+{
+	std::fill(m_counters, m_counters + static_cast<size_t>(MapCounter::Size), 0);
+}
+
+void MapSummaryTable::EndStage(const std::string& name, double time)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	auto stage = std::find_if(m_stages.begin(), m_stages.end(), [&name](const StageSummary& summary) { return summary.m_name == name; });
+
+	if (stage == m_stages.end())
+	{
+		m_stages.push_back({ name, 1, time, time, time });
+		return;
+	}
+
+	stage->m_calls++;
+	stage->m_totalTime += time;
+	stage->m_minTime = std::min(stage->m_minTime, time);
+	stage->m_maxTime = std::max(stage->m_maxTime, time);
+}
+
+void MapSummaryTable::AddCount(MapCounter counter, uint64_t value)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_counters[static_cast<size_t>(counter)] += value;
+}
+
+void MapSummaryTable::SetPeakMemory(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_peakMemory = std::max(m_peakMemory, bytes);
+}
+
+void MapSummaryTable::Print(std::ostream& out) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	std::ios::fmtflags flags = out.flags();
+
+	out << std::left << std::setw(26) << "Stage" << std::right << std::setw(7) << "Calls" << std::setw(12) << "Total ms"
+		<< std::setw(12) << "Min ms" << std::setw(12) << "Max ms" << std::endl;
+	out << std::fixed << std::setprecision(3);
+
+	for (const auto& stage : m_stages)
+	{
+		out << std::left << std::setw(26) << stage.m_name << std::right << std::setw(7) << stage.m_calls << std::setw(12) << stage.m_totalTime
+			<< std::setw(12) << stage.m_minTime << std::setw(12) << stage.m_maxTime << std::endl;
+	}
+
+	for (size_t counter = 0; counter < static_cast<size_t>(MapCounter::Size); ++counter)
+	{
+		out << std::left << std::setw(26) << GetCounterName(static_cast<MapCounter>(counter)) << std::right << std::setw(7) << ""
+			<< std::setw(12) << m_counters[counter] << std::endl;
+	}
+
+	out << std::left << std::setw(26) << "Peak memory (MB)" << std::right << std::setw(7) << ""
+		<< std::setw(12) << m_peakMemory / (1024.0 * 1024.0) << std::endl;
+
+	out.flags(flags);
+}
+
+void MapSummaryTable::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_stages.clear();
+	std::fill(m_counters, m_counters + static_cast<size_t>(MapCounter::Size), 0);
+	m_peakMemory = 0;
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#ifndef MAP_INSTRUMENTATION_H
+#define MAP_INSTRUMENTATION_H
+
+#include <mutex>
+#include <chrono>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <ostream>
+
+// Set to 0 to compile every instrumentation hook out of the generator
+#ifndef MAP_INSTRUMENTATION
+#define MAP_INSTRUMENTATION 1
+#endif
+
+enum class MapCounter
+{
+	// Sites placed before the triangulation
+	Points,
+	Triangles,
+	// Elements pushed on the queues of the flood fills
+	QueuePushes,
+
+	Size
+};
+
+const char* GetCounterName(MapCounter counter);
+
+// Receives the profiling events of a map generation.
+// Every method is a no-op by default. The stages of the task graph run concurrently,
+// so an implementation must accept calls from several threads at once.
+class MapInstrumentation
+{
+public:
+	MapInstrumentation() = default;
+
+	virtual ~MapInstrumentation() = default;
+
+	MapInstrumentation(const MapInstrumentation& instrumentation) = delete;
+	MapInstrumentation(MapInstrumentation&& instrumentation) = delete;
+
+	MapInstrumentation& operator=(const MapInstrumentation& instrumentation) = delete;
+	MapInstrumentation& operator=(MapInstrumentation&& instrumentation) = delete;
+
+	// Called on the thread running the stage, time is in milliseconds
+	virtual void BeginStage(const std::string& /*name*/) { }
+	virtual void EndStage(const std::string& /*name*/, double /*time*/) { }
+	// Adds value to a counter, once per stage and counter rather than once per element
+	virtual void AddCount(MapCounter /*counter*/, uint64_t /*value*/) { }
+	// Peak resident memory of the process, sent after every stage
+	virtual void SetPeakMemory(size_t /*bytes*/) { }
+
+	// Peak resident memory of the process so far, 0 if unknown
+	static size_t GetPeakMemory();
+};
+
+// Records the events in the Chrome trace event format, to be opened in chrome://tracing or Perfetto
+class MapChromeTrace : public MapInstrumentation
+{
+public:
+	MapChromeTrace();
+
+	~MapChromeTrace() = default;
+
+	void BeginStage(const std::string& name) override;
+	void EndStage(const std::string& name, double time) override;
+	void AddCount(MapCounter counter, uint64_t value) override;
+	void SetPeakMemory(size_t bytes) override;
+
+	bool Write(const std::string& path) const;
+	void Clear();
+
+private:
+	struct Event
+	{
+		std::string m_name;
+		char m_phase;
+		// Microseconds since the trace started
+		double m_timestamp;
+		unsigned int m_thread;
+		uint64_t m_value;
+	};
+
+	void AddEvent(const std::string& name, char phase, uint64_t value);
+	// Microseconds since m_start
+	double GetTimestamp() const;
+
+	mutable std::mutex m_mutex;
+	std::chrono::steady_clock::time_point m_start;
+	std::vector<Event> m_events;
+	std::vector<std::thread::id> m_threads;
+	uint64_t m_counters[static_cast<size_t>(MapCounter::Size)];
+};
+
+// Sums the stage times and counters over any number of generations, for a table at the end of a run
+class MapSummaryTable : public MapInstrumentation
+{
+public:
+	MapSummaryTable();
+
+	~MapSummaryTable() = default;
+
+	void EndStage(const std::string& name, double time) override;
+	void AddCount(MapCounter counter, uint64_t value) override;
+	void SetPeakMemory(size_t bytes) override;
+
+	void Print(std::ostream& out) const;
+	void Clear();
+
+private:
+	struct StageSummary
+	{
+		std::string m_name;
+		unsigned int m_calls;
+		double m_totalTime;
+		double m_minTime;
+		double m_maxTime;
+	};
+
+	mutable std::mutex m_mutex;
+	// In the order the stages first ended
+	std::vector<StageSummary> m_stages;
+	uint64_t m_counters[static_cast<size_t>(MapCounter::Size)];
+	size_t m_peakMemory;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,49 @@
+#include <cmath>
+#include <algorithm>
+
+#include "MapPalette.h"
+
+namespace
+{
+	// Palette entry of a value in [0, 1], the top of the range included
+	template <size_t N>
+	const MapColor& GetRampColor(const MapColor (&ramp)[N], double value)
+	{
+		int index = static_cast<int>(floor(value * 10));
+
+		return ramp[std::min(std::max(index, 0), static_cast<int>(N) - 1)];
+	}
+}
+
+MapColor MapPalette::GetCenterColor(MapView view, BiomeType biome, double elevation, double moisture, bool water, bool ocean)
+{
+	switch (view)
+	{
+	case MapView::Biomes:
+		return static_cast<size_t>(biome) < sizeof(BIOME) / sizeof(BIOME[0]) ? BIOME[static_cast<int>(biome)] : BACKGROUND;
+	case MapView::Elevation:
+		if (ocean)
+		{
+			return WATER;
+		}
+		else if (water)
+		{
+			return LAKE;
+		}
+
+		return GetRampColor(ELEVATION, elevation);
+	case MapView::Moisture:
+		if (ocean)
+		{
+			return WATER;
+		}
+		else if (water)
+		{
+			return LAKE;
+		}
+
+		return GetRampColor(MOISTURE, moisture);
+	default:
+		return BACKGROUND;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,468 @@
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <algorithm>
+
+#include "MapRaster.h"
+#include "Map.h"
+#include "ThreadPool.h"
+
+namespace
+{
+	// Rivers are at least this wide once scaled, in pixels, so that they stay visible on thumbnails
+	const double MIN_RIVER_WIDTH = 1.0;
+
+	// Stored deflate blocks hold at most this many bytes
+	const size_t MAX_STORED_BLOCK = 65535;
+
+	void WriteBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		bytes.push_back(static_cast<uint8_t>(value >> 24));
+		bytes.push_back(static_cast<uint8_t>(value >> 16));
+		bytes.push_back(static_cast<uint8_t>(value >> 8));
+		bytes.push_back(static_cast<uint8_t>(value));
+	}
+
+	uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size)
+	{
+		static const std::vector<uint32_t> table = []()
+		{
+			std::vector<uint32_t> entries(256);
+
+			for (uint32_t n = 0; n < 256; ++n)
+			{
+				uint32_t c = n;
+
+				for (int k = 0; k < 8; ++k)
+				{
+					c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+				}
+
+				entries[n] = c;
+			}
+
+			return entries;
+		}();
+
+		for (size_t i = 0; i < size; ++i)
+		{
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+
+		return crc;
+	}
+
+	// Length, type, data and CRC of the type and data
+	void WriteChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data)
+	{
+		std::vector<uint8_t> chunk;
+		WriteBigEndian(chunk, static_cast<uint32_t>(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		WriteBigEndian(chunk, UpdateCrc(0xFFFFFFFFu, chunk.data() + 4, chunk.size() - 4) ^ 0xFFFFFFFFu);
+
+		file.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+	}
+}
+
+const unsigned int MapRaster::TILE_SIZE;
+
+MapRaster::MapRaster() :
+	m_width(0), m_height(0), m_tileColumns(0), m_tileRows(0)
+{
+
+}
+
+void MapRaster::Render(const Map& map, MapView view, unsigned int width, unsigned int height, ThreadPool* threadPool)
+{
+	const Mesh& mesh = map.GetMesh();
+	const MapAttributes& attributes = map.GetAttributes();
+
+	m_width = width;
+	m_height = height;
+	m_pixels.resize(static_cast<size_t>(width) * height * 4);
+	m_shapeOffsets.assign(1, 0);
+	m_shapePoints.clear();
+	m_shapeColors.clear();
+
+	if (width == 0 || height == 0 || map.GetWidth() <= 0 || map.GetHeight() <= 0)
+	{
+		return;
+	}
+
+	Vector2 scale(static_cast<double>(width) / map.GetWidth(), static_cast<double>(height) / map.GetHeight());
+	auto toPixels = [&scale](const Vector2& position)
+	{
+		return Vector2(position.x * scale.x, position.y * scale.y);
+	};
+
+	// Cells first, then the rivers drawn over them
+	std::vector<Vector2> points;
+
+	for (unsigned int center = 0; center < mesh.GetCenterCount(); ++center)
+	{
+		if (mesh.m_centerCorners.Size(center) < 3)
+		{
+			continue;
+		}
+
+		points.clear();
+
+		for (const unsigned int* corner = mesh.m_centerCorners.Begin(center); corner != mesh.m_centerCorners.End(center); ++corner)
+		{
+			points.push_back(toPixels(mesh.m_cornerPositions[*corner]));
+		}
+
+		const CenterAttributes& centers = attributes.m_centers;
+		MapColor color = MapPalette::GetCenterColor(view, centers.m_biome[center], centers.m_elevation[center], centers.m_moisture[center],
+			centers.m_water.Test(center), centers.m_ocean.Test(center));
+
+		AddShape(points.data(), static_cast<unsigned int>(points.size()), color);
+	}
+
+	double riverScale = std::min(scale.x, scale.y);
+
+	for (unsigned int edge = 0; edge < mesh.GetEdgeCount(); ++edge)
+	{
+		double volume = attributes.m_edges.m_riverVolume[edge];
+
+		if (!(volume > 0.0))
+		{
+			continue;
+		}
+
+		// Same ends as the viewer, the midpoint of the sites for a missing corner
+		Vector2 midpoint = (mesh.m_centerPositions[mesh.m_edgeCenters[edge * 2]] + mesh.m_centerPositions[mesh.m_edgeCenters[edge * 2 + 1]]) / 2;
+		unsigned int v0 = mesh.m_edgeCorners[edge * 2];
+		unsigned int v1 = mesh.m_edgeCorners[edge * 2 + 1];
+		Vector2 a = toPixels(v0 != Mesh::INVALID_INDEX ? mesh.m_cornerPositions[v0] : midpoint);
+		Vector2 b = toPixels(v1 != Mesh::INVALID_INDEX ? mesh.m_cornerPositions[v1] : midpoint);
+
+		Vector2 direction(a, b);
+		double length = direction.Length();
+
+		if (length <= 0.0)
+		{
+			continue;
+		}
+
+		double halfWidth = std::max((1 + sqrt(volume)) * riverScale, MIN_RIVER_WIDTH) / 2;
+		Vector2 side(-direction.y * halfWidth / length, direction.x * halfWidth / length);
+		Vector2 quad[4] = { a - side, b - side, b + side, a + side };
+
+		AddShape(quad, 4, MapPalette::RIVER);
+	}
+
+	BinShapes();
+
+	unsigned int tileCount = m_tileColumns * m_tileRows;
+
+	if (threadPool != nullptr)
+	{
+		threadPool->ParallelFor(tileCount, 1, [this](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int tile = begin; tile < end; ++tile)
+			{
+				RenderTile(tile);
+			}
+		});
+	}
+	else
+	{
+		for (unsigned int tile = 0; tile < tileCount; ++tile)
+		{
+			RenderTile(tile);
+		}
+	}
+}
+
+unsigned int MapRaster::GetWidth() const
+{
+	return m_width;
+}
+
+unsigned int MapRaster::GetHeight() const
+{
+	return m_height;
+}
+
+const std::vector<uint8_t>& MapRaster::GetPixels() const
+{
+	return m_pixels;
+}
+
+bool MapRaster::WritePPM(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	file << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+	std::vector<uint8_t> row(static_cast<size_t>(m_width) * 3);
+
+	for (unsigned int y = 0; y < m_height; ++y)
+	{
+		const uint8_t* pixel = m_pixels.data() + static_cast<size_t>(y) * m_width * 4;
+
+		for (unsigned int x = 0; x < m_width; ++x, pixel += 4)
+		{
+			row[x * 3] = pixel[0];
+			row[x * 3 + 1] = pixel[1];
+			row[x * 3 + 2] = pixel[2];
+		}
+
+		file.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+
+	return file.good();
+}
+
+bool MapRaster::WritePNG(const std::string& path) const
+{
+	std::ofstream file(path, std::ios::binary);
+
+	if (!file)
+	{
+		return false;
+	}
+
+	static const uint8_t SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	file.write(reinterpret_cast<const char*>(SIGNATURE), sizeof(SIGNATURE));
+
+	// Width, height, 8 bits per channel, RGBA, deflate, adaptive filtering, no interlace
+	std::vector<uint8_t> header;
+	WriteBigEndian(header, m_width);
+	WriteBigEndian(header, m_height);
+	header.push_back(8);
+	header.push_back(6);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+	WriteChunk(file, "IHDR", header);
+
+	// Every row starts with filter type 0, the rows are wrapped in a zlib stream of stored blocks
+	size_t rowSize = static_cast<size_t>(m_width) * 4;
+	std::vector<uint8_t> scanlines;
+	scanlines.reserve((rowSize + 1) * m_height);
+
+	for (unsigned int y = 0; y < m_height; ++y)
+	{
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), m_pixels.begin() + y * rowSize, m_pixels.begin() + (y + 1) * rowSize);
+	}
+
+	std::vector<uint8_t> data;
+	data.reserve(scanlines.size() + scanlines.size() / MAX_STORED_BLOCK * 5 + 16);
+	data.push_back(0x78);
+	data.push_back(0x01);
+
+	size_t position = 0;
+
+	do
+	{
+		size_t size = std::min(scanlines.size() - position, MAX_STORED_BLOCK);
+		bool last = position + size == scanlines.size();
+
+		data.push_back(last ? 1 : 0);
+		data.push_back(static_cast<uint8_t>(size));
+		data.push_back(static_cast<uint8_t>(size >> 8));
+		data.push_back(static_cast<uint8_t>(~size));
+		data.push_back(static_cast<uint8_t>(~size >> 8));
+		data.insert(data.end(), scanlines.begin() + position, scanlines.begin() + position + size);
+
+		position += size;
+	} while (position < scanlines.size());
+
+	uint32_t a = 1, b = 0;
+
+	for (auto byte : scanlines)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+
+	WriteBigEndian(data, (b << 16) | a);
+	WriteChunk(file, "IDAT", data);
+	WriteChunk(file, "IEND", std::vector<uint8_t>());
+
+	return file.good();
+}
+
+void MapRaster::AddShape(const Vector2* points, unsigned int count, MapColor color)
+{
+	m_shapePoints.insert(m_shapePoints.end(), points, points + count);
+	m_shapeOffsets.push_back(static_cast<unsigned int>(m_shapePoints.size()));
+	m_shapeColors.push_back(color);
+}
+
+void MapRaster::BinShapes()
+{
+	m_tileColumns = (m_width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileRows = (m_height + TILE_SIZE - 1) / TILE_SIZE;
+
+	unsigned int shapeCount = static_cast<unsigned int>(m_shapeColors.size());
+	auto toTile = [](double pixel, unsigned int tileCount)
+	{
+		return std::min(static_cast<unsigned int>(std::max(pixel, 0.0)) / TILE_SIZE, tileCount - 1);
+	};
+
+	// Tile range covered by the bounding box of every shape, empty for shapes outside the image
+	m_shapeTiles.assign(shapeCount * 4, 0);
+
+	for (unsigned int shape = 0; shape < shapeCount; ++shape)
+	{
+		Vector2 minPoint = m_shapePoints[m_shapeOffsets[shape]];
+		Vector2 maxPoint = minPoint;
+
+		for (unsigned int i = m_shapeOffsets[shape] + 1; i < m_shapeOffsets[shape + 1]; ++i)
+		{
+			minPoint.x = std::min(minPoint.x, m_shapePoints[i].x);
+			minPoint.y = std::min(minPoint.y, m_shapePoints[i].y);
+			maxPoint.x = std::max(maxPoint.x, m_shapePoints[i].x);
+			maxPoint.y = std::max(maxPoint.y, m_shapePoints[i].y);
+		}
+
+		if (maxPoint.x < 0.0 || maxPoint.y < 0.0 || minPoint.x >= m_width || minPoint.y >= m_height)
+		{
+			continue;
+		}
+
+		unsigned int* range = &m_shapeTiles[shape * 4];
+		range[0] = toTile(minPoint.x, m_tileColumns);
+		range[1] = toTile(minPoint.y, m_tileRows);
+		range[2] = toTile(maxPoint.x, m_tileColumns) + 1;
+		range[3] = toTile(maxPoint.y, m_tileRows) + 1;
+	}
+
+	// Counting pass, then a fill pass in shape order so that every tile draws its shapes in order
+	m_tileOffsets.assign(m_tileColumns * m_tileRows + 1, 0);
+
+	for (unsigned int shape = 0; shape < shapeCount; ++shape)
+	{
+		const unsigned int* range = &m_shapeTiles[shape * 4];
+
+		for (unsigned int row = range[1]; row < range[3]; ++row)
+		{
+			for (unsigned int column = range[0]; column < range[2]; ++column)
+			{
+				m_tileOffsets[row * m_tileColumns + column + 1]++;
+			}
+		}
+	}
+
+	for (size_t tile = 1; tile < m_tileOffsets.size(); ++tile)
+	{
+		m_tileOffsets[tile] += m_tileOffsets[tile - 1];
+	}
+
+	std::vector<unsigned int> cursors(m_tileOffsets.begin(), m_tileOffsets.end() - 1);
+	m_tileShapes.resize(m_tileOffsets.back());
+
+	for (unsigned int shape = 0; shape < shapeCount; ++shape)
+	{
+		const unsigned int* range = &m_shapeTiles[shape * 4];
+
+		for (unsigned int row = range[1]; row < range[3]; ++row)
+		{
+			for (unsigned int column = range[0]; column < range[2]; ++column)
+			{
+				m_tileShapes[cursors[row * m_tileColumns + column]++] = shape;
+			}
+		}
+	}
+}
+
+void MapRaster::RenderTile(unsigned int tile)
+{
+	unsigned int minX = (tile % m_tileColumns) * TILE_SIZE;
+	unsigned int minY = (tile / m_tileColumns) * TILE_SIZE;
+	unsigned int maxX = std::min(minX + TILE_SIZE, m_width);
+	unsigned int maxY = std::min(minY + TILE_SIZE, m_height);
+
+	for (unsigned int y = minY; y < maxY; ++y)
+	{
+		uint8_t* pixel = &m_pixels[(static_cast<size_t>(y) * m_width + minX) * 4];
+
+		for (unsigned int x = minX; x < maxX; ++x, pixel += 4)
+		{
+			pixel[0] = MapPalette::BACKGROUND.r;
+			pixel[1] = MapPalette::BACKGROUND.g;
+			pixel[2] = MapPalette::BACKGROUND.b;
+			pixel[3] = MapPalette::BACKGROUND.a;
+		}
+	}
+
+	for (unsigned int i = m_tileOffsets[tile]; i < m_tileOffsets[tile + 1]; ++i)
+	{
+		FillPolygon(m_tileShapes[i], minX, minY, maxX, maxY);
+	}
+}
+
+void MapRaster::FillPolygon(unsigned int shape, unsigned int minX, unsigned int minY, unsigned int maxX, unsigned int maxY)
+{
+	const Vector2* points = m_shapePoints.data() + m_shapeOffsets[shape];
+	unsigned int count = m_shapeOffsets[shape + 1] - m_shapeOffsets[shape];
+	MapColor color = m_shapeColors[shape];
+
+	double top = points[0].y, bottom = points[0].y;
+
+	for (unsigned int i = 1; i < count; ++i)
+	{
+		top = std::min(top, points[i].y);
+		bottom = std::max(bottom, points[i].y);
+	}
+
+	// Rows whose pixel center lies in [top, bottom)
+	unsigned int firstRow = static_cast<unsigned int>(std::max(ceil(top - 0.5), static_cast<double>(minY)));
+	unsigned int lastRow = static_cast<unsigned int>(std::min(ceil(bottom - 0.5), static_cast<double>(maxY)));
+
+	for (unsigned int row = firstRow; row < lastRow; ++row)
+	{
+		double y = row + 0.5;
+		double left = std::numeric_limits<double>::infinity();
+		double right = -std::numeric_limits<double>::infinity();
+
+		// The polygon is convex, so the row crosses it in one span.
+		// Every edge is walked from its upper end, which gives both cells of a shared edge the same crossing.
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			const Vector2* a = &points[i];
+			const Vector2* b = &points[i + 1 < count ? i + 1 : 0];
+
+			if (b->y < a->y || (b->y == a->y && b->x < a->x))
+			{
+				std::swap(a, b);
+			}
+
+			if (a->y <= y && y < b->y)
+			{
+				double x = a->x + (y - a->y) * (b->x - a->x) / (b->y - a->y);
+				left = std::min(left, x);
+				right = std::max(right, x);
+			}
+		}
+
+		// Pixels whose center lies in [left, right)
+		double firstColumn = std::max(ceil(left - 0.5), static_cast<double>(minX));
+		double lastColumn = std::min(ceil(right - 0.5), static_cast<double>(maxX));
+
+		if (!(firstColumn < lastColumn))
+		{
+			continue;
+		}
+
+		uint8_t* pixel = &m_pixels[(static_cast<size_t>(row) * m_width + static_cast<unsigned int>(firstColumn)) * 4];
+
+		for (unsigned int column = static_cast<unsigned int>(firstColumn); column < static_cast<unsigned int>(lastColumn); ++column, pixel += 4)
+		{
+			pixel[0] = color.r;
+			pixel[1] = color.g;
+			pixel[2] = color.b;
+			pixel[3] = color.a;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,9 @@
+#include "MapWorkspace.h"
+#include "Noise/Noise.h"
+
+MapWorkspace::MapWorkspace() : m_noise(new noise::module::Perlin())
+{
+
+}
+
+MapWorkspace::~MapWorkspace() = default;
\ No newline at end of file
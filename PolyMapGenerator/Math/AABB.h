@@ -0,0 +1,51 @@
+#ifndef AABB_H
+#define AABB_H
+
+#include <cmath>
+
+#include "Vector2.h"
+
+// Axis-Aligned Bounding Box (AABB)
+struct AABB
+{
+	AABB() = default;
+	AABB(Vector2 pos, Vector2 half) : m_pos(pos), m_half(half) { }
+
+	~AABB() = default;
+
+	AABB(const AABB& aabb) = default;
+	AABB(AABB&& aabb) = default;
+
+	AABB& operator=(const AABB& aabb) = default;
+	AABB& operator=(AABB&& aabb) = default;
+
+	bool IsContain(const Vector2 point) const
+	{
+		Vector2 minPoint = m_pos - m_half;
+		if (point.x >= minPoint.x && point.y >= minPoint.y)
+		{
+			Vector2 maxPoint = m_pos + m_half;
+			return point.x <= maxPoint.x && point.y <= maxPoint.y;
+		}
+
+		return false;
+	}
+
+	bool IsIntersect(const AABB& sec) const
+	{
+		double diffX = std::abs(m_pos.x - sec.m_pos.x);
+		double diffY = std::abs(m_pos.y - sec.m_pos.y);
+
+		if (diffX > m_half.x + sec.m_half.x || diffY > m_half.y + sec.m_half.y)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	Vector2 m_pos;
+	Vector2 m_half;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include "Mesh.h"
+#include "Structure.h"
+
+namespace
+{
+	template <typename Node, typename Container>
+	void BuildAdjacency(const std::vector<Node*>& nodes, Container Node::* neighbours, Adjacency& adjacency)
+	{
+		adjacency.m_offsets.resize(nodes.size() + 1);
+		adjacency.m_indices.clear();
+
+		size_t total = 0;
+		for (size_t i = 0; i < nodes.size(); ++i)
+		{
+			adjacency.m_offsets[i] = static_cast<unsigned int>(total);
+			total += (nodes[i]->*neighbours).size();
+		}
+
+		adjacency.m_offsets[nodes.size()] = static_cast<unsigned int>(total);
+		adjacency.m_indices.reserve(total);
+
+		for (auto node : nodes)
+		{
+			for (auto neighbour : node->*neighbours)
+			{
+				adjacency.m_indices.push_back(neighbour->m_index);
+			}
+		}
+	}
+}
+
+const unsigned int Mesh::INVALID_INDEX;
+
+void Adjacency::Clear()
+{
+	m_offsets.clear();
+	m_indices.clear();
+}
+
+void Mesh::Build(const std::vector<Center*>& centers, const std::vector<Corner*>& corners, const std::vector<Edge*>& edges)
+{
+	Clear();
+
+	m_centerPositions.reserve(centers.size());
+	for (auto center : centers)
+	{
+		m_centerPositions.push_back(center->m_position);
+	}
+
+	m_cornerPositions.reserve(corners.size());
+	for (auto corner : corners)
+	{
+		m_cornerPositions.push_back(corner->m_position);
+	}
+
+	BuildAdjacency(centers, &Center::m_centers, m_centerCenters);
+	BuildAdjacency(centers, &Center::m_corners, m_centerCorners);
+	BuildAdjacency(centers, &Center::m_edges, m_centerEdges);
+
+	BuildAdjacency(corners, &Corner::m_corners, m_cornerCorners);
+	BuildAdjacency(corners, &Corner::m_centers, m_cornerCenters);
+	BuildAdjacency(corners, &Corner::m_edges, m_cornerEdges);
+
+	m_edgeCenters.resize(edges.size() * 2);
+	m_edgeCorners.resize(edges.size() * 2);
+
+	for (auto edge : edges)
+	{
+		unsigned int i = edge->m_index * 2;
+
+		m_edgeCenters[i] = edge->m_d0 != nullptr ? edge->m_d0->m_index : INVALID_INDEX;
+		m_edgeCenters[i + 1] = edge->m_d1 != nullptr ? edge->m_d1->m_index : INVALID_INDEX;
+		m_edgeCorners[i] = edge->m_v0 != nullptr ? edge->m_v0->m_index : INVALID_INDEX;
+		m_edgeCorners[i + 1] = edge->m_v1 != nullptr ? edge->m_v1->m_index : INVALID_INDEX;
+	}
+}
+
+void Mesh::Clear()
+{
+	m_centerPositions.clear();
+	m_cornerPositions.clear();
+
+	m_centerCenters.Clear();
+	m_centerCorners.Clear();
+	m_centerEdges.Clear();
+
+	m_cornerCorners.Clear();
+	m_cornerCenters.Clear();
+	m_cornerEdges.Clear();
+
+	m_edgeCenters.clear();
+	m_edgeCorners.clear();
+}
\ No newline at end of file
@@ -4,11 +4,9 @@
 #include <vector>
 #include <SFML/System.hpp>
 
+#include "Math/AABB.h"
 #include "Math/Vector2.h"
 
-// Forward Declaration
-struct AABB;
-
 template <typename T>
 class QuadTree
 {
@@ -16,9 +14,9 @@ public:
 	QuadTree() :
 		m_northWest(nullptr), m_northEast(nullptr),
 		m_southEast(nullptr), m_southWest(nullptr),
-		m_divided(false), m_branchDepth(0), m_elementsBranch(0) { }
-	QuadTree(AABB boundary, int depth) :
-		m_boundary(boundary), m_divided(false), m_branchDepth(depth), m_elementsBranch(0) { }
+		m_divided(false), m_branchDepth(0), m_maxDepth(MAX_TREE_DEPTH), m_elementsBranch(0) { }
+	QuadTree(AABB boundary, int depth, int maxDepth = MAX_TREE_DEPTH) :
+		m_boundary(boundary), m_divided(false), m_branchDepth(depth), m_maxDepth(maxDepth), m_elementsBranch(0) { }
 
 	~QuadTree()
 	{
@@ -111,7 +109,7 @@ public:
 
 		m_elementsBranch++;
 
-		if (m_branchDepth == MAX_TREE_DEPTH)
+		if (m_branchDepth == m_maxDepth)
 		{
 			m_elements.push_back(element);
 			m_elementsRegions.push_back(range);
@@ -184,11 +182,12 @@ public:
 		return elements;
 	}
 
-	static void SetMaxDepth(int d)
+	// Depth of the leaves built by Insert2, set it before inserting
+	void SetMaxDepth(int d)
 	{
 		if (d > 0)
 		{
-			MAX_TREE_DEPTH = d;
+			m_maxDepth = d;
 		}
 	}
 
@@ -203,19 +202,19 @@ private:
 
 		Vector2 nwPos(m_boundary.m_pos - newHalf);
 		AABB northWest(nwPos, newHalf);
-		m_northWest = new QuadTree<T>(northWest, m_branchDepth + 1);
+		m_northWest = new QuadTree<T>(northWest, m_branchDepth + 1, m_maxDepth);
 
 		Vector2 nePos(nwPos.x + m_boundary.m_half.x, nwPos.y);
 		AABB northEast(nePos, newHalf);
-		m_northEast = new QuadTree<T>(northEast, m_branchDepth + 1);
+		m_northEast = new QuadTree<T>(northEast, m_branchDepth + 1, m_maxDepth);
 
 		Vector2 sePos(m_boundary.m_pos + newHalf);
 		AABB southEast(sePos, newHalf);
-		m_southEast = new QuadTree<T>(southEast, m_branchDepth + 1);
+		m_southEast = new QuadTree<T>(southEast, m_branchDepth + 1, m_maxDepth);
 
 		Vector2 swPos(nwPos.x, nwPos.y + m_boundary.m_half.y);
 		AABB southWest(swPos, newHalf);
-		m_southWest = new QuadTree<T>(southWest, m_branchDepth + 1);
+		m_southWest = new QuadTree<T>(southWest, m_branchDepth + 1, m_maxDepth);
 
 		typename std::vector<std::pair<T, AABB>>::iterator iter;
 
@@ -250,19 +249,19 @@ private:
 
 		Vector2 nwPos(m_boundary.m_pos - newHalf);
 		AABB northWest(nwPos, newHalf);
-		m_northWest = new QuadTree<T>(northWest, m_branchDepth + 1);
+		m_northWest = new QuadTree<T>(northWest, m_branchDepth + 1, m_maxDepth);
 
 		Vector2 nePos(nwPos.x + m_boundary.m_half.x, nwPos.y);
 		AABB northEast(nePos, newHalf);
-		m_northEast = new QuadTree<T>(northEast, m_branchDepth + 1);
+		m_northEast = new QuadTree<T>(northEast, m_branchDepth + 1, m_maxDepth);
 
 		Vector2 sePos(m_boundary.m_pos + newHalf);
 		AABB southEast(sePos, newHalf);
-		m_southEast = new QuadTree<T>(southEast, m_branchDepth + 1);
+		m_southEast = new QuadTree<T>(southEast, m_branchDepth + 1, m_maxDepth);
 
 		Vector2 swPos(nwPos.x, nwPos.y + m_boundary.m_half.y);
 		AABB southWest(swPos, newHalf);
-		m_southWest = new QuadTree<T>(southWest, m_branchDepth + 1);
+		m_southWest = new QuadTree<T>(southWest, m_branchDepth + 1, m_maxDepth);
 	}
 
 	static int MAX_TREE_DEPTH;
@@ -277,53 +276,11 @@ private:
 
 	bool m_divided;
 	int m_branchDepth;
+	int m_maxDepth;
 	int m_elementsBranch;
 };
 
 template <typename T>
 int QuadTree<T>::MAX_TREE_DEPTH = 6;
 
-// Axis-Aligned Bounding Box (AABB)
-struct AABB
-{
-	AABB() = default;
-	AABB(Vector2 pos, Vector2 half) : m_pos(pos), m_half(half) { }
-
-	~AABB() = default;
-
-	AABB(const AABB& aabb) = default;
-	AABB(AABB&& aabb) = default;
-
-	AABB& operator=(const AABB& aabb) = default;
-	AABB& operator=(AABB&& aabb) = default;
-
-	bool IsContain(const Vector2 point) const
-	{
-		Vector2 minPoint = m_pos - m_half;
-		if (point.x >= minPoint.x && point.y >= minPoint.y)
-		{
-			Vector2 maxPoint = m_pos + m_half;
-			return point.x <= maxPoint.x && point.y <= maxPoint.y;
-		}
-
-		return false;
-	}
-
-	bool IsIntersect(const AABB& sec) const
-	{
-		double diffX = abs(m_pos.x - sec.m_pos.x);
-		double diffY = abs(m_pos.y - sec.m_pos.y);
-
-		if (diffX > m_half.x + sec.m_half.x || diffY > m_half.y + sec.m_half.y)
-		{
-			return false;
-		}
-
-		return true;
-	}
-
-	Vector2 m_pos;
-	Vector2 m_half;
-};
-
 #endif
\ No newline at end of file
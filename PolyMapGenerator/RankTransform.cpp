@@ -0,0 +1,96 @@
+#include <cstring>
+#include <algorithm>
+
+#include "RankTransform.h"
+
+namespace
+{
+	const unsigned int RADIX_BITS = 8;
+	const unsigned int RADIX_SIZE = 1 << RADIX_BITS;
+	const uint64_t SIGN_BIT = 0x8000000000000000ull;
+	// Smallest block worth a task of its own
+	const unsigned int MIN_BLOCK_SIZE = 16384;
+}
+
+uint64_t GetRankKey(double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	// Negative numbers sort in reverse on their bits, so every bit is flipped, positive ones only get above them
+	return (bits & SIGN_BIT) != 0 ? ~bits : bits | SIGN_BIT;
+}
+
+void RadixSort(std::vector<RankEntry>& entries, std::vector<RankEntry>& scratch, ThreadPool& pool)
+{
+	unsigned int count = static_cast<unsigned int>(entries.size());
+
+	if (count < 2)
+	{
+		return;
+	}
+
+	// A fixed partition, so that the scatter of a block uses the offsets counted on that same block
+	unsigned int blockCount = std::max(1u, std::min(pool.GetThreadCount() * 4, count / MIN_BLOCK_SIZE));
+	unsigned int blockSize = (count + blockCount - 1) / blockCount;
+	std::vector<unsigned int> histograms(blockCount * RADIX_SIZE);
+	scratch.resize(count);
+
+	for (unsigned int shift = 0; shift < 64; shift += RADIX_BITS)
+	{
+		std::fill(histograms.begin(), histograms.end(), 0);
+
+		pool.ParallelFor(blockCount, 1, [&entries, &histograms, count, blockSize, shift](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int b = begin; b < end; ++b)
+			{
+				unsigned int* histogram = &histograms[b * RADIX_SIZE];
+				unsigned int last = std::min(count, (b + 1) * blockSize);
+
+				for (unsigned int i = b * blockSize; i < last; ++i)
+				{
+					histogram[(entries[i].m_key >> shift) & (RADIX_SIZE - 1)]++;
+				}
+			}
+		});
+
+		// Digit major, block minor offsets: a digit of an earlier block lands first, which keeps the sort stable
+		unsigned int offset = 0;
+		bool sameDigit = false;
+
+		for (unsigned int digit = 0; digit < RADIX_SIZE; ++digit)
+		{
+			unsigned int digitBegin = offset;
+
+			for (unsigned int b = 0; b < blockCount; ++b)
+			{
+				unsigned int digitCount = histograms[b * RADIX_SIZE + digit];
+				histograms[b * RADIX_SIZE + digit] = offset;
+				offset += digitCount;
+			}
+
+			sameDigit = sameDigit || offset - digitBegin == count;
+		}
+
+		if (sameDigit)
+		{
+			continue;
+		}
+
+		pool.ParallelFor(blockCount, 1, [&entries, &scratch, &histograms, count, blockSize, shift](unsigned int begin, unsigned int end)
+		{
+			for (unsigned int b = begin; b < end; ++b)
+			{
+				unsigned int* offsets = &histograms[b * RADIX_SIZE];
+				unsigned int last = std::min(count, (b + 1) * blockSize);
+
+				for (unsigned int i = b * blockSize; i < last; ++i)
+				{
+					scratch[offsets[(entries[i].m_key >> shift) & (RADIX_SIZE - 1)]++] = entries[i];
+				}
+			}
+		});
+
+		entries.swap(scratch);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#ifndef RANK_TRANSFORM_H
+#define RANK_TRANSFORM_H
+
+#include <vector>
+#include <cstdint>
+
+#include "ThreadPool.h"
+
+// Sort key and element index of one value of a rank transform
+struct RankEntry
+{
+	uint64_t m_key;
+	unsigned int m_index;
+};
+
+// Unsigned key with the same order as the double, so that doubles sort as integers
+uint64_t GetRankKey(double value);
+
+// Stable LSD radix sort of the entries by key, 8 bits per pass, every pass split in blocks over the pool.
+// Passes where all the keys share the same digit are skipped. scratch is resized and swapped with entries.
+void RadixSort(std::vector<RankEntry>& entries, std::vector<RankEntry>& scratch, ThreadPool& pool);
+
+// Replaces values[indices[i]] by mapping(rank / (count - 1)), where rank is the position of the value
+// among the indexed values in ascending order. Equal values are ranked in the order of indices.
+// A single indexed value is mapped from 0, the rank of the lowest value.
+// entries and scratch are buffers kept by the caller between calls.
+template <typename Mapping>
+void RankTransform(std::vector<double>& values, const std::vector<unsigned int>& indices, std::vector<RankEntry>& entries, std::vector<RankEntry>& scratch, ThreadPool& pool, Mapping mapping)
+{
+	const unsigned int GRAIN_SIZE = 4096;
+	unsigned int count = static_cast<unsigned int>(indices.size());
+	entries.resize(count);
+
+	pool.ParallelFor(count, GRAIN_SIZE, [&values, &indices, &entries](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			entries[i] = { GetRankKey(values[indices[i]]), indices[i] };
+		}
+	});
+
+	RadixSort(entries, scratch, pool);
+
+	pool.ParallelFor(count, GRAIN_SIZE, [&values, &entries, &mapping, count](unsigned int begin, unsigned int end)
+	{
+		for (unsigned int i = begin; i < end; ++i)
+		{
+			// 0 / 0 for a single value, which would hand NaN to the mapping
+			values[entries[i].m_index] = mapping(count > 1 ? static_cast<double>(i) / (count - 1) : 0.0);
+		}
+	});
+}
+
+#endif
\ No newline at end of file
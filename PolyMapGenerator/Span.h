@@ -0,0 +1,48 @@
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <cstddef>
+#include <cassert>
+#include <vector>
+
+// Non-owning view of a contiguous array
+template <typename T>
+class Span
+{
+public:
+	Span() : m_data(nullptr), m_size(0) { }
+	Span(T* data, size_t size) : m_data(data), m_size(size) { }
+
+	template <typename U>
+	Span(std::vector<U>& v) : m_data(v.data()), m_size(v.size()) { }
+	template <typename U>
+	Span(const std::vector<U>& v) : m_data(v.data()), m_size(v.size()) { }
+
+	~Span() = default;
+
+	Span(const Span& s) = default;
+	Span(Span&& s) = default;
+
+	Span& operator=(const Span& s) = default;
+	Span& operator=(Span&& s) = default;
+
+	T& operator[](size_t i) const
+	{
+		assert(i < m_size);
+
+		return m_data[i];
+	}
+
+	T* begin() const { return m_data; }
+	T* end() const { return m_data + m_size; }
+
+	T* Data() const { return m_data; }
+	size_t Size() const { return m_size; }
+	bool IsEmpty() const { return m_size == 0; }
+
+private:
+	T* m_data;
+	size_t m_size;
+};
+
+#endif
\ No newline at end of file
@@ -1,6 +1,15 @@
+#include <cmath>
+#include <algorithm>
+
 #include "Math/LineEquation.h"
 #include "Structure.h"
 
+namespace
+{
+	// Corners of the center being sorted with their angle, reused by the next center of the thread
+	thread_local std::vector<std::pair<double, Corner*>> t_cornerKeys;
+}
+
 Edge::Edge(unsigned int index, Center* center1, Center* center2, Corner* corner1, Corner* corner2) :
 	m_index(index), m_d0(center1), m_d1(center2), m_v0(corner1), m_v1(corner2), m_riverVolume(0.0)
 {
@@ -132,40 +141,60 @@ std::pair<Vector2, Vector2> Center::GetBoundingBox()
 
 void Center::SortCorners()
 {
-	Corner* item = nullptr;
-	int hole = 0;
+	// Every corner gets one angle key up front, instead of two vectors per comparison.
+	// The key is a pseudo-angle in [0, 4) growing counterclockwise, with y pointing up, from straight down,
+	// which orders like the angle without calling atan2.
+	std::vector<std::pair<double, Corner*>>& keys = t_cornerKeys;
+	keys.clear();
 
-	for (size_t i = 1; i < m_corners.size(); ++i)
+	for (auto corner : m_corners)
 	{
-		item = m_corners[i];
-		hole = i;
-		
-		while (hole > 0 && IsGoesBefore(item->m_position, m_corners[hole - 1]->m_position))
+		double dx = corner->m_position.x - m_position.x;
+		double dy = corner->m_position.y - m_position.y;
+		double sum = std::abs(dx) + std::abs(dy);
+		double key = sum > 0.0 ? (dx >= 0.0 ? 1.0 + dy / sum : 3.0 - dy / sum) : 0.0;
+
+		keys.push_back(std::make_pair(key, corner));
+	}
+
+	// Insertion sort, the few corners of a polygon are nearly always short
+	for (size_t i = 1; i < keys.size(); ++i)
+	{
+		std::pair<double, Corner*> item = keys[i];
+		size_t hole = i;
+
+		while (hole > 0 && (item.first < keys[hole - 1].first ||
+			(item.first == keys[hole - 1].first && item.second->m_index < keys[hole - 1].second->m_index)))
 		{
-			m_corners[hole] = m_corners[hole - 1];
+			keys[hole] = keys[hole - 1];
 			hole--;
 		}
 
-		m_corners[hole] = item;
+		keys[hole] = item;
 	}
-}
 
-bool Center::IsGoesBefore(Vector2 a, Vector2 b) const
-{
-	if ((a - m_position).x >= 0 && (b - m_position).x < 0)
+	// Corners that do not surround the center, on the hull of the map, start after the open side,
+	// the only turn of more than half a circle, so that they run as one chain
+	size_t first = 0;
+
+	for (size_t i = 0; keys.size() > 2 && i < keys.size(); ++i)
 	{
-		return true;
+		Vector2 a(m_position, keys[i].second->m_position);
+		Vector2 b(m_position, keys[(i + 1) % keys.size()].second->m_position);
+
+		if (a.CrossProduct(b) < 0.0)
+		{
+			first = (i + 1) % keys.size();
+			break;
+		}
 	}
 
-	if (a.x == 0 && b.x == 0)
+	for (size_t i = 0; i < keys.size(); ++i)
 	{
-		return a.y < b.y;
+		m_corners[i] = keys[(first + i) % keys.size()].second;
 	}
 
-	Vector2 ca(m_position, a);
-	Vector2 cb(m_position, b);
-
-	return ca.CrossProduct(cb) > 0;
+	m_cornersSorted = true;
 }
 
 bool Edge::Legalize()
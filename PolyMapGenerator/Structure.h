@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include "Arena.h"
 #include "Math/Vector2.h"
 
 enum class BiomeType
@@ -35,10 +36,11 @@ struct Center
 {
 	Center() :
 		m_index(0), m_position(0, 0), m_water(false), m_ocean(false), m_coast(false), m_border(false),
-		m_biome(BiomeType::None), m_elevation(0.0), m_moisture(0.0) { }
-	Center(unsigned int index, Vector2 position) :
+		m_biome(BiomeType::None), m_elevation(0.0), m_moisture(0.0), m_cornersSorted(false) { }
+	Center(unsigned int index, Vector2 position, Arena* arena = nullptr) :
 		m_index(index), m_position(position), m_water(false), m_ocean(false), m_coast(false), m_border(false),
-		m_biome(BiomeType::None), m_elevation(0.0), m_moisture(0.0) { }
+		m_biome(BiomeType::None), m_elevation(0.0), m_moisture(0.0), m_cornersSorted(false),
+		m_edges(ArenaAllocator<Edge*>(arena)), m_corners(ArenaAllocator<Corner*>(arena)), m_centers(ArenaAllocator<Center*>(arena)) { }
 
 	~Center() = default;
 
@@ -55,8 +57,8 @@ struct Center
 	bool IsInsideBoundingBox(int width, int height) const;
 	bool IsContain(Vector2 pos);
 	std::pair<Vector2, Vector2> GetBoundingBox();
+	// Orders m_corners around the center and sets m_cornersSorted, done once when the map is built
 	void SortCorners();
-	bool IsGoesBefore(Vector2 a, Vector2 b) const;
 
 	unsigned int m_index;
 	Vector2 m_position;
@@ -68,12 +70,15 @@ struct Center
 	BiomeType m_biome;
 	double m_elevation;
 	double m_moisture;
+	// Whether m_corners is in polygon order, so that it can be drawn without sorting again
+	bool m_cornersSorted;
 
-	std::vector<Edge*> m_edges;
-	std::vector<Corner*> m_corners;
-	std::vector<Center*> m_centers;
+	// Allocated from the arena of the map, if any
+	ArenaVector<Edge*> m_edges;
+	ArenaVector<Corner*> m_corners;
+	ArenaVector<Center*> m_centers;
 
-	using CenterIterator = std::vector<Center*>::iterator;
+	using CenterIterator = ArenaVector<Center*>::iterator;
 };
 
 struct Edge
@@ -113,9 +118,10 @@ struct Corner
 	Corner() :
 		m_index(0), m_position(0, 0), m_water(false), m_ocean(false), m_coast(false), m_border(false),
 		m_elevation(0.0), m_moisture(0.0), m_riverVolume(0.0), m_downslope(nullptr) { }
-	Corner(unsigned int index, Vector2 position) :
+	Corner(unsigned int index, Vector2 position, Arena* arena = nullptr) :
 		m_index(index), m_position(position), m_water(false), m_ocean(false), m_coast(false), m_border(false),
-		m_elevation(0.0), m_moisture(0.0), m_riverVolume(0.0), m_downslope(nullptr) { }
+		m_elevation(0.0), m_moisture(0.0), m_riverVolume(0.0), m_downslope(nullptr),
+		m_edges(ArenaAllocator<Edge*>(arena)), m_corners(ArenaAllocator<Corner*>(arena)), m_centers(ArenaAllocator<Center*>(arena)) { }
 
 	bool IsPointInCircumstanceCircle(Vector2 p);
 	Vector2 CalculateCircumstanceCenter();
@@ -141,11 +147,12 @@ struct Corner
 	double m_riverVolume;
 	Corner* m_downslope;
 
-	std::vector<Edge*> m_edges;
-	std::vector<Corner*> m_corners;
-	std::vector<Center*> m_centers;
+	// Allocated from the arena of the map, if any
+	ArenaVector<Edge*> m_edges;
+	ArenaVector<Corner*> m_corners;
+	ArenaVector<Center*> m_centers;
 
-	using CornerIterator = std::vector<Corner*>::iterator;
+	using CornerIterator = ArenaVector<Corner*>::iterator;
 };
 
 #endif
\ No newline at end of file
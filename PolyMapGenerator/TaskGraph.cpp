@@ -0,0 +1,83 @@
+#include <SFML/System.hpp>
+
+#include "TaskGraph.h"
+#include "ThreadPool.h"
+
+unsigned int TaskGraph::AddStage(std::string name, ChannelMask inputs, ChannelMask outputs, std::function<void()> function)
+{
+	unsigned int index = static_cast<unsigned int>(m_stages.size());
+	unsigned int dependencyCount = 0;
+
+	for (unsigned int i = 0; i < index; ++i)
+	{
+		Stage& stage = m_stages[i];
+
+		if ((stage.m_outputs & (inputs | outputs)) != 0 || (stage.m_inputs & outputs) != 0)
+		{
+			stage.m_dependents.push_back(index);
+			dependencyCount++;
+		}
+	}
+
+	m_stages.push_back(Stage{ std::move(name), inputs, outputs, std::move(function), std::vector<unsigned int>(), dependencyCount, 0.0 });
+
+	return index;
+}
+
+void TaskGraph::Run(ThreadPool& pool)
+{
+	TaskGroup group;
+	m_remainingDependencies.reset(new std::atomic<unsigned int>[m_stages.size()]);
+
+	for (size_t i = 0; i < m_stages.size(); ++i)
+	{
+		m_remainingDependencies[i] = m_stages[i].m_dependencyCount;
+	}
+
+	for (unsigned int i = 0; i < m_stages.size(); ++i)
+	{
+		if (m_stages[i].m_dependencyCount == 0)
+		{
+			pool.Submit(group, [this, &pool, &group, i]()
+			{
+				RunStage(pool, group, i);
+			});
+		}
+	}
+
+	pool.Wait(group);
+}
+
+unsigned int TaskGraph::GetStageCount() const
+{
+	return static_cast<unsigned int>(m_stages.size());
+}
+
+const std::string& TaskGraph::GetStageName(unsigned int stage) const
+{
+	return m_stages[stage].m_name;
+}
+
+double TaskGraph::GetStageTime(unsigned int stage) const
+{
+	return m_stages[stage].m_time;
+}
+
+void TaskGraph::RunStage(ThreadPool& pool, TaskGroup& group, unsigned int stage)
+{
+	sf::Clock timer;
+
+	m_stages[stage].m_function();
+	m_stages[stage].m_time = timer.getElapsedTime().asMicroseconds() / 1000.0;
+
+	for (auto dependent : m_stages[stage].m_dependents)
+	{
+		if (m_remainingDependencies[dependent].fetch_sub(1) == 1)
+		{
+			pool.Submit(group, [this, &pool, &group, dependent]()
+			{
+				RunStage(pool, group, dependent);
+			});
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef TASK_GRAPH_H
+#define TASK_GRAPH_H
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+
+// Forward Declaration
+class ThreadPool;
+class TaskGroup;
+
+// Dependency graph of pipeline stages.
+// Each stage declares the data channels it reads and writes as bit masks; a stage runs after every
+// earlier stage that writes what it reads, or reads or writes what it writes, and in parallel with the rest.
+class TaskGraph
+{
+public:
+	typedef uint32_t ChannelMask;
+
+	TaskGraph() = default;
+
+	~TaskGraph() = default;
+
+	TaskGraph(const TaskGraph& graph) = delete;
+	TaskGraph(TaskGraph&& graph) = delete;
+
+	TaskGraph& operator=(const TaskGraph& graph) = delete;
+	TaskGraph& operator=(TaskGraph&& graph) = delete;
+
+	unsigned int AddStage(std::string name, ChannelMask inputs, ChannelMask outputs, std::function<void()> function);
+	void Run(ThreadPool& pool);
+
+	unsigned int GetStageCount() const;
+	const std::string& GetStageName(unsigned int stage) const;
+	// Duration of the stage in the last Run, in milliseconds
+	double GetStageTime(unsigned int stage) const;
+
+private:
+	struct Stage
+	{
+		std::string m_name;
+		ChannelMask m_inputs;
+		ChannelMask m_outputs;
+		std::function<void()> m_function;
+		std::vector<unsigned int> m_dependents;
+		unsigned int m_dependencyCount;
+		double m_time;
+	};
+
+	void RunStage(ThreadPool& pool, TaskGroup& group, unsigned int stage);
+
+	std::vector<Stage> m_stages;
+	std::unique_ptr<std::atomic<unsigned int>[]> m_remainingDependencies;
+};
+
+#endif
\ No newline at end of file
@@ -0,0 +1,256 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Queue owned by the current thread, queue 0 is shared by the threads outside the pool
+	thread_local const ThreadPool* t_pool = nullptr;
+	thread_local unsigned int t_queueIndex = 0;
+}
+
+ThreadPool::ThreadPool(unsigned int threadCount) :
+	m_threadCount(threadCount != 0 ? threadCount : std::max(std::thread::hardware_concurrency(), 1u)),
+	m_queuedTasks(0), m_nextQueue(0), m_stop(false)
+{
+	for (unsigned int i = 0; i < m_threadCount; ++i)
+	{
+		m_queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+	}
+
+	for (unsigned int i = 1; i < m_threadCount; ++i)
+	{
+		m_workers.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_stop = true;
+	}
+	m_sleepCondition.notify_all();
+
+	for (auto& worker : m_workers)
+	{
+		worker.join();
+	}
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return m_threadCount;
+}
+
+void ThreadPool::Submit(TaskGroup& group, std::function<void()> task)
+{
+	group.m_pending.fetch_add(1);
+	group.m_queued.fetch_add(1);
+
+	// Workers push to their own queue, outside threads spread their tasks round-robin
+	unsigned int queueIndex = t_pool == this ? t_queueIndex : m_nextQueue.fetch_add(1) % m_threadCount;
+	WorkQueue& queue = *m_queues[queueIndex];
+
+	{
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+		queue.m_tasks.push_back(Task{ std::move(task), &group });
+	}
+
+	m_queuedTasks.fetch_add(1);
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_sleepCondition.notify_one();
+
+	// Wakes a thread waiting on the group, so that it can run the new task itself
+	std::lock_guard<std::mutex> lock(group.m_mutex);
+	group.m_condition.notify_all();
+}
+
+void ThreadPool::Wait(TaskGroup& group)
+{
+	unsigned int queueIndex = GetQueueIndex();
+	Task task;
+
+	while (true)
+	{
+		if (PopTask(queueIndex, &group, task))
+		{
+			RunTask(task);
+			continue;
+		}
+
+		// The last task decrements m_pending under this lock, so once it reads 0 here no thread touches the group any more
+		std::unique_lock<std::mutex> lock(group.m_mutex);
+		group.m_condition.wait(lock, [&group]()
+		{
+			return group.m_pending.load() == 0 || group.m_queued.load() > 0;
+		});
+
+		if (group.m_pending.load() == 0)
+		{
+			break;
+		}
+	}
+
+	std::exception_ptr exception = group.m_exception;
+	group.m_exception = nullptr;
+
+	if (exception)
+	{
+		std::rethrow_exception(exception);
+	}
+}
+
+void ThreadPool::ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function)
+{
+	grainSize = std::max(grainSize, 1u);
+
+	// About four chunks per thread, rounded up to the grain
+	unsigned int chunkSize = (count + m_threadCount * 4 - 1) / (m_threadCount * 4);
+	chunkSize = std::max((chunkSize + grainSize - 1) / grainSize * grainSize, grainSize);
+
+	if (m_threadCount == 1 || count <= chunkSize)
+	{
+		function(0, count);
+		return;
+	}
+
+	TaskGroup group;
+
+	for (unsigned int begin = chunkSize; begin < count; begin += chunkSize)
+	{
+		unsigned int end = std::min(begin + chunkSize, count);
+		Submit(group, [&function, begin, end]()
+		{
+			function(begin, end);
+		});
+	}
+
+	// The chunks reference function and group, so they are waited on even if the first chunk throws
+	try
+	{
+		function(0, chunkSize);
+	}
+	catch (...)
+	{
+		Wait(group);
+		throw;
+	}
+
+	Wait(group);
+}
+
+unsigned int ThreadPool::GetQueueIndex() const
+{
+	return t_pool == this ? t_queueIndex : 0;
+}
+
+bool ThreadPool::PopTask(unsigned int queueIndex, const TaskGroup* group, Task& task)
+{
+	if (group != nullptr && group->m_queued.load() == 0)
+	{
+		return false;
+	}
+
+	// Own queue from the back, the others from the front, skipping the tasks of other groups
+	for (unsigned int i = 0; i < m_threadCount; ++i)
+	{
+		WorkQueue& queue = *m_queues[(queueIndex + i) % m_threadCount];
+		std::lock_guard<std::mutex> lock(queue.m_mutex);
+
+		size_t count = queue.m_tasks.size();
+		size_t index = count;
+
+		for (size_t j = 0; j < count && index == count; ++j)
+		{
+			size_t k = i == 0 ? count - 1 - j : j;
+
+			if (group == nullptr || queue.m_tasks[k].m_group == group)
+			{
+				index = k;
+			}
+		}
+
+		if (index == count)
+		{
+			continue;
+		}
+
+		task = std::move(queue.m_tasks[index]);
+		queue.m_tasks.erase(queue.m_tasks.begin() + index);
+		task.m_group->m_queued.fetch_sub(1);
+		m_queuedTasks.fetch_sub(1);
+
+		return true;
+	}
+
+	return false;
+}
+
+void ThreadPool::RunTask(Task& task)
+{
+	// Finishes the task even if it throws, so that Wait never hangs on it
+	struct FinishGuard
+	{
+		~FinishGuard()
+		{
+			std::lock_guard<std::mutex> lock(m_group.m_mutex);
+
+			if (m_group.m_pending.fetch_sub(1) == 1)
+			{
+				m_group.m_condition.notify_all();
+			}
+		}
+
+		TaskGroup& m_group;
+	};
+
+	TaskGroup& group = *task.m_group;
+	FinishGuard guard = { group };
+
+	try
+	{
+		task.m_function();
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(group.m_mutex);
+
+		if (!group.m_exception)
+		{
+			group.m_exception = std::current_exception();
+		}
+	}
+
+	task.m_function = nullptr;
+}
+
+void ThreadPool::WorkerLoop(unsigned int queueIndex)
+{
+	t_pool = this;
+	t_queueIndex = queueIndex;
+	Task task;
+
+	while (true)
+	{
+		if (PopTask(queueIndex, nullptr, task))
+		{
+			RunTask(task);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepCondition.wait(lock, [this]()
+		{
+			return m_stop || m_queuedTasks.load() > 0;
+		});
+
+		if (m_stop)
+		{
+			return;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <condition_variable>
+
+// Counter of the tasks submitted for one job, waited on with ThreadPool::Wait
+class TaskGroup
+{
+public:
+	TaskGroup() : m_pending(0), m_queued(0) { }
+
+	~TaskGroup() = default;
+
+	TaskGroup(const TaskGroup& group) = delete;
+	TaskGroup(TaskGroup&& group) = delete;
+
+	TaskGroup& operator=(const TaskGroup& group) = delete;
+	TaskGroup& operator=(TaskGroup&& group) = delete;
+
+	bool IsDone() const { return m_pending.load() == 0; }
+
+private:
+	friend class ThreadPool;
+
+	std::atomic<unsigned int> m_pending;
+	// Tasks of the group still waiting in a queue
+	std::atomic<unsigned int> m_queued;
+
+	// Signaled when a task of the group is queued or the last one finishes
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	// First exception thrown by a task of the group, rethrown by Wait
+	std::exception_ptr m_exception;
+};
+
+// Work-stealing thread pool.
+// Every worker owns a deque, pops its own tasks from the back and steals from the front of the others.
+// The calling thread counts as one of the threads: it runs the tasks of the group it waits on,
+// so a pool of one thread spawns no workers and runs everything inline.
+// A waiting thread only helps with its own group, which keeps the stack depth and the number of jobs
+// in flight bounded by the nesting of the groups rather than by the number of tasks queued.
+class ThreadPool
+{
+public:
+	// 0 uses std::thread::hardware_concurrency()
+	explicit ThreadPool(unsigned int threadCount = 0);
+
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool& pool) = delete;
+	ThreadPool(ThreadPool&& pool) = delete;
+
+	ThreadPool& operator=(const ThreadPool& pool) = delete;
+	ThreadPool& operator=(ThreadPool&& pool) = delete;
+
+	unsigned int GetThreadCount() const;
+
+	void Submit(TaskGroup& group, std::function<void()> task);
+	// Runs the queued tasks of the group, then sleeps until the rest is done.
+	// Rethrows the first exception thrown by a task of the group.
+	void Wait(TaskGroup& group);
+
+	// Calls function(begin, end) on chunks of [0, count) and waits for all of them.
+	// Chunk bounds are multiples of grainSize, so with a grain multiple of 64 no two chunks share a BitSet word.
+	void ParallelFor(unsigned int count, unsigned int grainSize, const std::function<void(unsigned int, unsigned int)>& function);
+
+private:
+	struct Task
+	{
+		std::function<void()> m_function;
+		TaskGroup* m_group;
+	};
+
+	struct WorkQueue
+	{
+		std::mutex m_mutex;
+		std::deque<Task> m_tasks;
+	};
+
+	unsigned int GetQueueIndex() const;
+	// Takes a task of any group when group is nullptr
+	bool PopTask(unsigned int queueIndex, const TaskGroup* group, Task& task);
+	void RunTask(Task& task);
+	void WorkerLoop(unsigned int queueIndex);
+
+	unsigned int m_threadCount;
+	std::vector<std::unique_ptr<WorkQueue>> m_queues;
+	std::vector<std::thread> m_workers;
+
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+	std::atomic<int> m_queuedTasks;
+	std::atomic<unsigned int> m_nextQueue;
+	std::atomic<bool> m_stop;
+};
+
+#endif
\ No newline at end of file
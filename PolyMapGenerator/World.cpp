@@ -0,0 +1,571 @@
+#include <cmath>
+#include <random>
+#include <algorithm>
+
+#include "World.h"
+#include "Map.h"
+#include "MapFile.h"
+#include "Structure.h"
+#include "ThreadPool.h"
+#include "DelaunayTriangulation.h"
+#include "Noise/Noise.h"
+
+namespace
+{
+	// Steps a river is traced for, a corner only collects rivers from sources this close
+	const unsigned int MAX_RIVER_LENGTH = 16;
+	// Cells of the finest noise feature
+	const double FEATURE_CELLS = 32.0;
+	// Noise value below which a corner starts as water, and from which land reaches full elevation
+	const double SEA_LEVEL = 0.0;
+	const double MOUNTAIN_LEVEL = 0.8;
+	// One corner in RIVER_SPACING is a river source, if it lies in the source elevation band
+	const uint64_t RIVER_SPACING = 6;
+	const size_t DEFAULT_CACHE_CAPACITY = 16;
+
+	uint64_t SplitMix(uint64_t x)
+	{
+		x += 0x9E3779B97F4A7C15ull;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+
+		return x ^ (x >> 31);
+	}
+
+	// Key of world cell (i, j), also the id of its center
+	uint64_t GetCellKey(int i, int j)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(i)) << 32) | static_cast<uint32_t>(j);
+	}
+
+	double ToUnit(uint64_t x)
+	{
+		return static_cast<double>(x >> 11) * (1.0 / 9007199254740992.0);
+	}
+
+	double Clamp(double value)
+	{
+		return std::min(std::max(value, 0.0), 1.0);
+	}
+
+	// Circumcenter of three sites given in key order, so that every tile computes the same bits
+	Vector2 GetCircumcenter(const Vector2& a, const Vector2& b, const Vector2& c)
+	{
+		double bx = b.x - a.x;
+		double by = b.y - a.y;
+		double cx = c.x - a.x;
+		double cy = c.y - a.y;
+		double d = 2.0 * (bx * cy - by * cx);
+		double b2 = bx * bx + by * by;
+		double c2 = cx * cx + cy * cy;
+
+		return Vector2(a.x + (cy * b2 - by * c2) / d, a.y + (bx * c2 - cx * b2) / d);
+	}
+}
+
+World::World(unsigned int tileCells, double pointSpread, std::string seed) :
+	m_tileCells(std::max(tileCells, 1u)), m_pointSpread(pointSpread), m_seed(seed),
+	m_landNoise(new noise::module::Perlin()), m_moistureNoise(new noise::module::Perlin()), m_cacheCapacity(DEFAULT_CACHE_CAPACITY)
+{
+	// Empty circumcircles are smaller than the diagonal of a cell, so Voronoi edges are shorter than two diagonals.
+	// A corner depends on the river sources MAX_RIVER_LENGTH edges away, plus a few cells to get their own neighbours right.
+	m_haloCells = static_cast<unsigned int>(std::ceil(2.0 * std::sqrt(2.0) * (MAX_RIVER_LENGTH + 3))) + 1;
+
+	std::mt19937 mt_rand(Map::HashString(m_seed));
+	m_pointSeed = (static_cast<uint64_t>(mt_rand()) << 32) | mt_rand();
+	m_riverSeed = (static_cast<uint64_t>(mt_rand()) << 32) | mt_rand();
+	m_landNoise->SetSeed(static_cast<int>(mt_rand()));
+	m_moistureNoise->SetSeed(static_cast<int>(mt_rand()));
+}
+
+World::~World() = default;
+
+std::shared_ptr<const WorldTile> World::GetTile(int x, int y)
+{
+	uint64_t key = GetCellKey(x, y);
+	auto entry = m_cacheEntries.find(key);
+
+	if (entry != m_cacheEntries.end())
+	{
+		m_cache.splice(m_cache.begin(), m_cache, entry->second);
+		return entry->second->second;
+	}
+
+	std::shared_ptr<const WorldTile> tile(GenerateTile(x, y));
+
+	if (m_cacheCapacity > 0)
+	{
+		m_cache.emplace_front(key, tile);
+		m_cacheEntries[key] = m_cache.begin();
+		Evict();
+	}
+
+	return tile;
+}
+
+std::unique_ptr<WorldTile> World::GenerateTile(int x, int y) const
+{
+	int side = static_cast<int>(m_tileCells + 2 * m_haloCells);
+	int firstI = x * static_cast<int>(m_tileCells) - static_cast<int>(m_haloCells);
+	int firstJ = y * static_cast<int>(m_tileCells) - static_cast<int>(m_haloCells);
+	unsigned int siteCount = static_cast<unsigned int>(side * side);
+
+	auto isOwned = [this, side](unsigned int site)
+	{
+		unsigned int i = site % side;
+		unsigned int j = site / side;
+
+		return i >= m_haloCells && i < m_haloCells + m_tileCells && j >= m_haloCells && j < m_haloCells + m_tileCells;
+	};
+
+	// Sites of the tile and its halo, one per cell and row by row
+	std::vector<DelaunayTriangulation::Vertex> points(siteCount);
+	std::vector<uint64_t> siteKeys(siteCount);
+
+	for (int j = 0; j < side; ++j)
+	{
+		for (int i = 0; i < side; ++i)
+		{
+			unsigned int site = static_cast<unsigned int>(j * side + i);
+			uint64_t key = GetCellKey(firstI + i, firstJ + j);
+			uint64_t hash = SplitMix(m_pointSeed ^ key);
+
+			siteKeys[site] = key;
+			points[site] = DelaunayTriangulation::Vertex((firstI + i + 0.1 + 0.8 * ToUnit(hash)) * m_pointSpread,
+				(firstJ + j + 0.1 + 0.8 * ToUnit(SplitMix(hash))) * m_pointSpread);
+		}
+	}
+
+	std::vector<unsigned int> triangles;
+	std::vector<unsigned int> halfEdges;
+	DelaunayTriangulation::Delaunay().Triangulate(points, triangles, halfEdges);
+
+	unsigned int cornerCount = static_cast<unsigned int>(triangles.size() / 3);
+
+	auto getPosition = [&points](unsigned int site)
+	{
+		return Vector2(points[site].GetX(), points[site].GetY());
+	};
+
+	// Triangles of every site, and corner positions and ids from the sites in key order
+	std::vector<unsigned int> siteCornerOffsets(siteCount + 1, 0);
+	std::vector<unsigned int> siteCorners(triangles.size());
+	std::vector<Vector2> cornerPositions(cornerCount);
+	std::vector<uint64_t> cornerIds(cornerCount);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		unsigned int sites[3] = { triangles[q * 3], triangles[q * 3 + 1], triangles[q * 3 + 2] };
+		std::sort(sites, sites + 3, [&siteKeys](unsigned int a, unsigned int b) { return siteKeys[a] < siteKeys[b]; });
+
+		cornerPositions[q] = GetCircumcenter(getPosition(sites[0]), getPosition(sites[1]), getPosition(sites[2]));
+		cornerIds[q] = SplitMix(SplitMix(SplitMix(siteKeys[sites[0]]) ^ siteKeys[sites[1]]) ^ siteKeys[sites[2]]);
+
+		for (unsigned int site : sites)
+		{
+			siteCornerOffsets[site + 1]++;
+		}
+	}
+
+	for (unsigned int site = 0; site < siteCount; ++site)
+	{
+		siteCornerOffsets[site + 1] += siteCornerOffsets[site];
+	}
+
+	std::vector<unsigned int> cursors(siteCornerOffsets.begin(), siteCornerOffsets.end() - 1);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			siteCorners[cursors[triangles[q * 3 + k]]++] = q;
+		}
+	}
+
+	// Land from the noise at every corner, then the polygon flags the way Map::AssignOceanCoastLand sets them
+	double noiseScale = 1.0 / (FEATURE_CELLS * m_pointSpread);
+	std::vector<double> landValues(cornerCount);
+	std::vector<char> siteWater(siteCount);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		landValues[q] = m_landNoise->GetValue(cornerPositions[q].x * noiseScale, cornerPositions[q].y * noiseScale, 0.5);
+	}
+
+	for (unsigned int site = 0; site < siteCount; ++site)
+	{
+		unsigned int adjacentWater = 0;
+
+		for (unsigned int k = siteCornerOffsets[site]; k < siteCornerOffsets[site + 1]; ++k)
+		{
+			adjacentWater += static_cast<unsigned int>(landValues[siteCorners[k]] < SEA_LEVEL);
+		}
+
+		siteWater[site] = adjacentWater >= (siteCornerOffsets[site + 1] - siteCornerOffsets[site]) * 0.5;
+	}
+
+	std::vector<char> cornerOcean(cornerCount);
+	std::vector<char> cornerCoast(cornerCount);
+	std::vector<double> cornerElevations(cornerCount);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		unsigned int adjacentOcean = 0;
+
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			adjacentOcean += static_cast<unsigned int>(siteWater[triangles[q * 3 + k]]);
+		}
+
+		cornerOcean[q] = adjacentOcean == 3;
+		cornerCoast[q] = adjacentOcean > 0 && adjacentOcean < 3;
+		cornerElevations[q] = cornerOcean[q] ? 0.0 : Clamp((landValues[q] - SEA_LEVEL) / (MOUNTAIN_LEVEL - SEA_LEVEL));
+	}
+
+	// Lowest strictly lower neighbour, equal elevations broken by id so that no tile depends on the triangle order
+	std::vector<unsigned int> downslopes(cornerCount);
+	std::vector<unsigned int> downslopeHalfEdges(cornerCount, DelaunayTriangulation::NO_HALF_EDGE);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		unsigned int d = q;
+
+		for (unsigned int halfEdge = q * 3; halfEdge < q * 3 + 3; ++halfEdge)
+		{
+			if (halfEdges[halfEdge] == DelaunayTriangulation::NO_HALF_EDGE)
+			{
+				continue;
+			}
+
+			unsigned int r = halfEdges[halfEdge] / 3;
+
+			if (cornerElevations[r] < cornerElevations[q] && (d == q || cornerElevations[r] < cornerElevations[d] ||
+				(cornerElevations[r] == cornerElevations[d] && cornerIds[r] < cornerIds[d])))
+			{
+				d = r;
+				downslopeHalfEdges[q] = halfEdge;
+			}
+		}
+
+		downslopes[q] = d;
+	}
+
+	// Rivers, with the edge volume kept on the lower half-edge of every edge
+	std::vector<double> cornerRiverVolumes(cornerCount, 0.0);
+	std::vector<double> halfEdgeRiverVolumes(triangles.size(), 0.0);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		if (cornerOcean[q] || cornerElevations[q] < 0.3 || cornerElevations[q] > 0.9 ||
+			SplitMix(m_riverSeed ^ cornerIds[q]) % RIVER_SPACING != 0)
+		{
+			continue;
+		}
+
+		unsigned int r = q;
+
+		for (unsigned int step = 0; step < MAX_RIVER_LENGTH && !cornerCoast[r] && downslopes[r] != r; ++step)
+		{
+			unsigned int halfEdge = downslopeHalfEdges[r];
+
+			halfEdgeRiverVolumes[std::min(halfEdge, halfEdges[halfEdge])] += 1;
+			cornerRiverVolumes[r] += 1;
+			cornerRiverVolumes[downslopes[r]] += 1;
+			r = downslopes[r];
+		}
+	}
+
+	std::vector<double> cornerMoistures(cornerCount);
+
+	for (unsigned int q = 0; q < cornerCount; ++q)
+	{
+		double noiseValue = m_moistureNoise->GetValue(cornerPositions[q].x * noiseScale, cornerPositions[q].y * noiseScale, 0.5);
+
+		cornerMoistures[q] = cornerOcean[q] ? 1.0 : Clamp(0.5 + 0.5 * noiseValue + std::min(0.2 * cornerRiverVolumes[q], 0.6));
+	}
+
+	// Graph of the owned sites: their centers, all their corners and every edge touching them
+	Arena arena;
+	std::vector<Center*> centers;
+	std::vector<Corner*> corners;
+	std::vector<Edge*> edges;
+	std::vector<Center*> siteCenters(siteCount, nullptr);
+	std::vector<Corner*> triangleCorners(cornerCount, nullptr);
+	std::vector<Edge*> halfEdgeEdges(triangles.size(), nullptr);
+	std::vector<unsigned int> centerSites;
+	std::vector<unsigned int> cornerTriangles;
+	std::vector<unsigned int> edgeHalfEdges;
+
+	std::unique_ptr<WorldTile> tile(new WorldTile());
+	tile->m_x = x;
+	tile->m_y = y;
+
+	for (unsigned int site = 0; site < siteCount; ++site)
+	{
+		if (isOwned(site))
+		{
+			siteCenters[site] = arena.New<Center>(static_cast<unsigned int>(centers.size()), getPosition(site), &arena);
+			centers.push_back(siteCenters[site]);
+			centerSites.push_back(site);
+			tile->m_centerIds.push_back(siteKeys[site]);
+		}
+	}
+
+	for (size_t c = 0; c < centers.size(); ++c)
+	{
+		unsigned int site = centerSites[c];
+
+		for (unsigned int k = siteCornerOffsets[site]; k < siteCornerOffsets[site + 1]; ++k)
+		{
+			unsigned int q = siteCorners[k];
+
+			if (triangleCorners[q] == nullptr)
+			{
+				triangleCorners[q] = arena.New<Corner>(static_cast<unsigned int>(corners.size()), cornerPositions[q], &arena);
+				corners.push_back(triangleCorners[q]);
+				cornerTriangles.push_back(q);
+				tile->m_cornerIds.push_back(cornerIds[q]);
+
+				for (unsigned int l = 0; l < 3; ++l)
+				{
+					if (siteCenters[triangles[q * 3 + l]] != nullptr)
+					{
+						triangleCorners[q]->m_centers.push_back(siteCenters[triangles[q * 3 + l]]);
+					}
+				}
+			}
+
+			centers[c]->m_corners.push_back(triangleCorners[q]);
+		}
+	}
+
+	for (size_t c = 0; c < corners.size(); ++c)
+	{
+		unsigned int q = cornerTriangles[c];
+
+		for (unsigned int halfEdge = q * 3; halfEdge < q * 3 + 3; ++halfEdge)
+		{
+			Center* d0 = siteCenters[triangles[halfEdge]];
+			Center* d1 = siteCenters[triangles[halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1]];
+			unsigned int twin = halfEdges[halfEdge];
+
+			if (d0 == nullptr && d1 == nullptr)
+			{
+				continue;
+			}
+
+			Edge* e = twin != DelaunayTriangulation::NO_HALF_EDGE ? halfEdgeEdges[twin] : nullptr;
+
+			if (e == nullptr)
+			{
+				Corner* v1 = twin != DelaunayTriangulation::NO_HALF_EDGE ? triangleCorners[twin / 3] : nullptr;
+
+				e = arena.New<Edge>(static_cast<unsigned int>(edges.size()), d0, d1, corners[c], v1);
+				edges.push_back(e);
+				edgeHalfEdges.push_back(twin != DelaunayTriangulation::NO_HALF_EDGE ? std::min(halfEdge, twin) : halfEdge);
+
+				for (Center* center : { d0, d1 })
+				{
+					if (center != nullptr)
+					{
+						center->m_edges.push_back(e);
+					}
+				}
+			}
+
+			halfEdgeEdges[halfEdge] = e;
+			corners[c]->m_edges.push_back(e);
+
+			Corner* opposite = e->GetOppositeCorner(corners[c]);
+
+			if (opposite != nullptr)
+			{
+				corners[c]->m_corners.push_back(opposite);
+			}
+		}
+	}
+
+	for (Center* center : centers)
+	{
+		center->SortCorners();
+
+		for (Edge* e : center->m_edges)
+		{
+			Center* opposite = e->GetOppositeCenter(center);
+
+			if (opposite != nullptr)
+			{
+				center->m_centers.push_back(opposite);
+			}
+		}
+	}
+
+	tile->m_mesh.Build(centers, corners, edges);
+
+	MapAttributes& attributes = tile->m_attributes;
+	attributes.Resize(tile->m_mesh);
+
+	for (size_t c = 0; c < corners.size(); ++c)
+	{
+		unsigned int q = cornerTriangles[c];
+		Edge* downslopeEdge = downslopes[q] != q ? halfEdgeEdges[downslopeHalfEdges[q]] : nullptr;
+
+		attributes.m_corners.m_elevation[c] = cornerElevations[q];
+		attributes.m_corners.m_moisture[c] = cornerMoistures[q];
+		attributes.m_corners.m_riverVolume[c] = cornerRiverVolumes[q];
+		attributes.m_corners.m_water.Set(c, cornerOcean[q] != 0);
+		attributes.m_corners.m_ocean.Set(c, cornerOcean[q] != 0);
+		attributes.m_corners.m_coast.Set(c, cornerCoast[q] != 0);
+
+		if (downslopes[q] == q)
+		{
+			attributes.m_corners.m_downslope[c] = static_cast<unsigned int>(c);
+			attributes.m_corners.m_downslopeEdge[c] = Mesh::INVALID_INDEX;
+		}
+		else
+		{
+			attributes.m_corners.m_downslope[c] = downslopeEdge != nullptr ? downslopeEdge->GetOppositeCorner(corners[c])->m_index : Mesh::INVALID_INDEX;
+			attributes.m_corners.m_downslopeEdge[c] = downslopeEdge != nullptr ? downslopeEdge->m_index : Mesh::INVALID_INDEX;
+		}
+	}
+
+	for (size_t e = 0; e < edges.size(); ++e)
+	{
+		attributes.m_edges.m_riverVolume[e] = halfEdgeRiverVolumes[edgeHalfEdges[e]];
+	}
+
+	// Polygon averages summed in corner id order, which is the same in every tile
+	std::vector<std::pair<uint64_t, unsigned int>> polygonCorners;
+	MapParameters parameters;
+
+	for (unsigned int c = 0; c < tile->m_mesh.GetCenterCount(); ++c)
+	{
+		polygonCorners.clear();
+
+		for (const unsigned int* q = tile->m_mesh.m_centerCorners.Begin(c); q != tile->m_mesh.m_centerCorners.End(c); ++q)
+		{
+			polygonCorners.push_back(std::make_pair(tile->m_cornerIds[*q], *q));
+		}
+
+		std::sort(polygonCorners.begin(), polygonCorners.end());
+
+		double elevation = 0.0;
+		double moisture = 0.0;
+
+		for (const auto& corner : polygonCorners)
+		{
+			elevation += attributes.m_corners.m_elevation[corner.second];
+			moisture += attributes.m_corners.m_moisture[corner.second];
+		}
+
+		unsigned int site = centerSites[c];
+		bool water = siteWater[site] != 0;
+		bool landNeighbour = false;
+		bool oceanNeighbour = false;
+
+		for (unsigned int k = siteCornerOffsets[site]; k < siteCornerOffsets[site + 1]; ++k)
+		{
+			for (unsigned int l = siteCorners[k] * 3; l < siteCorners[k] * 3 + 3; ++l)
+			{
+				if (triangles[l] != site)
+				{
+					landNeighbour = landNeighbour || !siteWater[triangles[l]];
+					oceanNeighbour = oceanNeighbour || siteWater[triangles[l]];
+				}
+			}
+		}
+
+		bool coast = landNeighbour && oceanNeighbour;
+
+		elevation /= polygonCorners.size();
+		moisture /= polygonCorners.size();
+
+		attributes.m_centers.m_elevation[c] = elevation;
+		attributes.m_centers.m_moisture[c] = moisture;
+		attributes.m_centers.m_water.Set(c, water);
+		attributes.m_centers.m_ocean.Set(c, water);
+		attributes.m_centers.m_coast.Set(c, coast);
+		attributes.m_centers.m_biome[c] = Map::GetBiome(water, water, coast, elevation, moisture, parameters);
+	}
+
+	return tile;
+}
+
+void World::Stream(int minX, int minY, int maxX, int maxY, const Consumer& consumer, ThreadPool* threadPool)
+{
+	if (threadPool == nullptr)
+	{
+		for (int y = minY; y < maxY; ++y)
+		{
+			for (int x = minX; x < maxX; ++x)
+			{
+				consumer(*GenerateTile(x, y));
+			}
+		}
+
+		return;
+	}
+
+	TaskGroup group;
+
+	for (int y = minY; y < maxY; ++y)
+	{
+		for (int x = minX; x < maxX; ++x)
+		{
+			threadPool->Submit(group, [this, &consumer, x, y]()
+			{
+				std::unique_ptr<WorldTile> tile = GenerateTile(x, y);
+
+				std::lock_guard<std::mutex> lock(m_consumerMutex);
+				consumer(*tile);
+			});
+		}
+	}
+
+	threadPool->Wait(group);
+}
+
+bool World::SaveTile(const WorldTile& tile, const std::string& path)
+{
+	return MapFile::Write(path, tile.m_mesh, tile.m_attributes, Map::HashGraph(tile.m_mesh, tile.m_attributes));
+}
+
+size_t World::GetCacheCapacity() const
+{
+	return m_cacheCapacity;
+}
+
+void World::SetCacheCapacity(size_t capacity)
+{
+	m_cacheCapacity = capacity;
+	Evict();
+}
+
+unsigned int World::GetTileCells() const
+{
+	return m_tileCells;
+}
+
+double World::GetPointSpread() const
+{
+	return m_pointSpread;
+}
+
+double World::GetTileSize() const
+{
+	return m_tileCells * m_pointSpread;
+}
+
+unsigned int World::GetHaloCells() const
+{
+	return m_haloCells;
+}
+
+void World::Evict()
+{
+	while (m_cache.size() > m_cacheCapacity)
+	{
+		m_cacheEntries.erase(m_cache.back().first);
+		m_cache.pop_back();
+	}
+}
\ No newline at end of file
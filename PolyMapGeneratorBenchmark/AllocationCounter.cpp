@@ -0,0 +1,178 @@
+#include <new>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+
+#include "AllocationCounter.h"
+
+namespace
+{
+	std::atomic<uint64_t> allocations(0);
+	std::atomic<uint64_t> allocatedBytes(0);
+
+	void Count(size_t size)
+	{
+		allocations.fetch_add(1, std::memory_order_relaxed);
+		allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	}
+
+	void* Allocate(size_t size)
+	{
+		Count(size);
+
+		return std::malloc(size > 0 ? size : 1);
+	}
+
+#ifdef __cpp_aligned_new
+	void* AllocateAligned(size_t size, size_t alignment)
+	{
+		Count(size);
+
+		if (size == 0)
+		{
+			size = 1;
+		}
+
+#ifdef _WIN32
+		return _aligned_malloc(size, alignment);
+#else
+		void* p = nullptr;
+
+		return posix_memalign(&p, std::max(alignment, sizeof(void*)), size) == 0 ? p : nullptr;
+#endif
+	}
+
+	void FreeAligned(void* p)
+	{
+#ifdef _WIN32
+		_aligned_free(p);
+#else
+		std::free(p);
+#endif
+	}
+#endif
+}
+
+AllocationCount GetAllocationCount()
+{
+	return { allocations.load(std::memory_order_relaxed), allocatedBytes.load(std::memory_order_relaxed) };
+}
+
+// Every replaceable form of operator new and delete is defined here, so that none of them
+// falls back to the runtime library, whose delete would not match this new
+
+void* operator new(size_t size)
+{
+	void* p = Allocate(size);
+
+	if (p == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return p;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return Allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept
+{
+	std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept
+{
+	std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+void* operator new(size_t size, std::align_val_t alignment)
+{
+	void* p = AllocateAligned(size, static_cast<size_t>(alignment));
+
+	if (p == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+
+	return p;
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+	return operator new(size, alignment);
+}
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+	return AllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* p, std::align_val_t) noexcept
+{
+	FreeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept
+{
+	FreeAligned(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept
+{
+	FreeAligned(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept
+{
+	FreeAligned(p);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,16 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// Heap allocations made through operator new since the start of the program, on every thread.
+// The benchmark replaces the global operator new and delete to count them.
+struct AllocationCount
+{
+	uint64_t m_allocations;
+	uint64_t m_bytes;
+};
+
+AllocationCount GetAllocationCount();
+
+#endif
\ No newline at end of file
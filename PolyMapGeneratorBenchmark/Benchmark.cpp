@@ -0,0 +1,379 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <SFML/System.hpp>
+
+#include "Arena.h"
+#include "DelaunayTriangulation.h"
+#include "Map.h"
+#include "MapRaster.h"
+#include "RegressionCheck.h"
+#include "StageBenchmark.h"
+#include "Structure.h"
+#include "PoissonDiskSampling/PoissonDiskSampling.h"
+
+const int WIDTH = 1600;
+const int HEIGHT = 1200;
+const int RUNS = 5;
+const int QUERIES = 10000;
+const int CHECKED_QUERIES = 100;
+
+struct Triangulation
+{
+	std::vector<DelaunayTriangulation::Vertex> m_sites;
+	std::vector<unsigned int> m_triangles;
+	std::vector<unsigned int> m_halfEdges;
+};
+
+// Median duration of a number of runs, in milliseconds
+double Measure(const std::function<void()>& function)
+{
+	std::vector<double> times;
+	sf::Clock timer;
+
+	for (int i = 0; i < RUNS; ++i)
+	{
+		timer.restart();
+		function();
+		times.push_back(timer.getElapsedTime().asMicroseconds() / 1000.0);
+	}
+
+	std::sort(times.begin(), times.end());
+
+	return times[times.size() / 2];
+}
+
+Triangulation Triangulate(double pointSpread)
+{
+	Triangulation triangulation;
+	PoissonDiskSampling pds(WIDTH, HEIGHT, pointSpread, 10);
+
+	for (auto point : pds.Generate(0, 1))
+	{
+		triangulation.m_sites.push_back(DelaunayTriangulation::Vertex(static_cast<int>(point.first), static_cast<int>(point.second)));
+	}
+
+	// Same far corner sites as Map::GeneratePoints, each one neighbour of a large part of the hull
+	triangulation.m_sites.push_back(DelaunayTriangulation::Vertex(-WIDTH, -HEIGHT));
+	triangulation.m_sites.push_back(DelaunayTriangulation::Vertex(2 * WIDTH, -HEIGHT));
+	triangulation.m_sites.push_back(DelaunayTriangulation::Vertex(2 * WIDTH, 2 * HEIGHT));
+	triangulation.m_sites.push_back(DelaunayTriangulation::Vertex(-WIDTH, 2 * HEIGHT));
+
+	std::sort(triangulation.m_sites.begin(), triangulation.m_sites.end());
+	triangulation.m_sites.erase(std::unique(triangulation.m_sites.begin(), triangulation.m_sites.end()), triangulation.m_sites.end());
+
+	DelaunayTriangulation::Delaunay delaunay;
+	delaunay.Triangulate(triangulation.m_sites, triangulation.m_triangles, triangulation.m_halfEdges);
+
+	return triangulation;
+}
+
+std::vector<Center*> CreateCenters(const Triangulation& triangulation, Arena& arena)
+{
+	std::vector<Center*> centers;
+
+	for (unsigned int i = 0; i < triangulation.m_sites.size(); ++i)
+	{
+		Vector2 position(triangulation.m_sites[i].GetX(), triangulation.m_sites[i].GetY());
+		centers.push_back(arena.New<Center>(i, position, &arena));
+	}
+
+	return centers;
+}
+
+// Previous path of Map::Triangulate: scan the edges of a center for every triangle side
+size_t BuildEdgesByScan(const Triangulation& triangulation)
+{
+	Arena arena;
+	std::vector<Center*> centers = CreateCenters(triangulation, arena);
+	size_t edgeCount = 0;
+
+	for (size_t t = 0; t < triangulation.m_triangles.size(); t += 3)
+	{
+		for (unsigned int k = 0; k < 3; ++k)
+		{
+			Center* d0 = centers[triangulation.m_triangles[t + k]];
+			Center* d1 = centers[triangulation.m_triangles[t + (k + 1) % 3]];
+
+			if (d0->GetEdgeWith(d1) == nullptr)
+			{
+				Edge* e = arena.New<Edge>(static_cast<unsigned int>(edgeCount++), d0, d1, nullptr, nullptr);
+				d0->m_edges.push_back(e);
+				d1->m_edges.push_back(e);
+			}
+		}
+	}
+
+	return edgeCount;
+}
+
+// Current path: the twin half-edge of the triangulation gives the already built edge
+size_t BuildEdgesByTwin(const Triangulation& triangulation)
+{
+	Arena arena;
+	std::vector<Center*> centers = CreateCenters(triangulation, arena);
+	std::vector<Edge*> halfEdgeEdges(triangulation.m_triangles.size(), nullptr);
+	size_t edgeCount = 0;
+
+	for (unsigned int halfEdge = 0; halfEdge < triangulation.m_triangles.size(); ++halfEdge)
+	{
+		unsigned int twin = triangulation.m_halfEdges[halfEdge];
+		Edge* e = twin != DelaunayTriangulation::NO_HALF_EDGE ? halfEdgeEdges[twin] : nullptr;
+
+		if (e == nullptr)
+		{
+			Center* d0 = centers[triangulation.m_triangles[halfEdge]];
+			Center* d1 = centers[triangulation.m_triangles[halfEdge % 3 == 2 ? halfEdge - 2 : halfEdge + 1]];
+
+			e = arena.New<Edge>(static_cast<unsigned int>(edgeCount++), d0, d1, nullptr, nullptr);
+			d0->m_edges.push_back(e);
+			d1->m_edges.push_back(e);
+		}
+
+		halfEdgeEdges[halfEdge] = e;
+	}
+
+	return edgeCount;
+}
+
+void BenchmarkDualEdges(double pointSpread)
+{
+	Triangulation triangulation = Triangulate(pointSpread);
+	size_t scanEdges = 0, twinEdges = 0;
+
+	double scanTime = Measure([&]() { scanEdges = BuildEdgesByScan(triangulation); });
+	double twinTime = Measure([&]() { twinEdges = BuildEdgesByTwin(triangulation); });
+
+	std::cout << "Dual edges, " << triangulation.m_sites.size() << " sites: scan " << scanTime << " ms (" << scanEdges << " edges), "
+		<< "twin " << twinTime << " ms (" << twinEdges << " edges)" << std::endl;
+}
+
+void BenchmarkRiverEdges(double pointSpread)
+{
+	Map map(WIDTH, HEIGHT, pointSpread, "benchmark");
+	map.Generate();
+
+	std::vector<Corner*> corners = map.GetCorners();
+	const std::vector<unsigned int>& downslopeEdges = map.GetAttributes().m_corners.m_downslopeEdge;
+	size_t scanSum = 0, lookupSum = 0;
+
+	double scanTime = Measure([&]()
+	{
+		scanSum = 0;
+		for (auto corner : corners)
+		{
+			if (corner->m_downslope != corner)
+			{
+				scanSum += corner->GetEdgeWith(corner->m_downslope)->m_index;
+			}
+		}
+	});
+
+	double lookupTime = Measure([&]()
+	{
+		lookupSum = 0;
+		for (size_t i = 0; i < downslopeEdges.size(); ++i)
+		{
+			if (downslopeEdges[i] != Mesh::INVALID_INDEX)
+			{
+				lookupSum += downslopeEdges[i];
+			}
+		}
+	});
+
+	std::cout << "Downslope edges, " << corners.size() << " corners: scan " << scanTime << " ms, lookup " << lookupTime << " ms"
+		<< (scanSum == lookupSum ? "" : " (MISMATCH)") << std::endl;
+}
+
+// Sum of the indices of the centers, order independent so it compares with a brute force scan
+size_t SumIndices(const std::vector<Center*>& centers)
+{
+	size_t sum = 0;
+
+	for (auto center : centers)
+	{
+		sum += center->m_index;
+	}
+
+	return sum;
+}
+
+void BenchmarkSpatialQueries(double pointSpread)
+{
+	Map map(WIDTH, HEIGHT, pointSpread, "benchmark");
+	map.Generate();
+
+	std::vector<Center*> centers = map.GetCenters();
+	std::mt19937 generator(1);
+	std::uniform_real_distribution<double> xDistribution(0.0, WIDTH), yDistribution(0.0, HEIGHT);
+	std::vector<Vector2> positions(QUERIES);
+
+	for (auto& position : positions)
+	{
+		position = Vector2(xDistribution(generator), yDistribution(generator));
+	}
+
+	double radius = 5.0 * pointSpread;
+	Vector2 half(5.0 * pointSpread, 5.0 * pointSpread);
+	const unsigned int nearestCount = 8;
+	std::vector<Center*> result;
+	size_t radiusSum = 0, rangeSum = 0, nearestSum = 0;
+
+	double radiusTime = Measure([&]()
+	{
+		radiusSum = 0;
+		for (auto position : positions)
+		{
+			map.GetCentersInRadius(position, radius, result);
+			radiusSum += result.size();
+		}
+	});
+
+	double rangeTime = Measure([&]()
+	{
+		rangeSum = 0;
+		for (auto position : positions)
+		{
+			map.GetCentersInRange(AABB(position, half), result);
+			rangeSum += result.size();
+		}
+	});
+
+	double nearestTime = Measure([&]()
+	{
+		nearestSum = 0;
+		for (auto position : positions)
+		{
+			map.GetNearestCenters(position, nearestCount, result);
+			nearestSum += result.size();
+		}
+	});
+
+	// Brute force over every center for the first queries
+	bool match = true;
+
+	for (int i = 0; i < CHECKED_QUERIES; ++i)
+	{
+		Vector2 position = positions[i];
+		AABB range(position, half);
+		std::vector<Center*> inRadius, inRange;
+		std::vector<std::pair<double, unsigned int>> distances;
+
+		for (auto center : centers)
+		{
+			double distance = Vector2(center->m_position, position).LengthSqrt();
+			std::pair<Vector2, Vector2> bounds = center->GetBoundingBox();
+
+			if (distance <= radius * radius)
+			{
+				inRadius.push_back(center);
+			}
+			if (AABB(bounds.first, bounds.second).IsIntersect(range))
+			{
+				inRange.push_back(center);
+			}
+
+			distances.push_back(std::make_pair(distance, center->m_index));
+		}
+
+		std::partial_sort(distances.begin(), distances.begin() + nearestCount, distances.end());
+
+		map.GetCentersInRadius(position, radius, result);
+		match = match && result.size() == inRadius.size() && SumIndices(result) == SumIndices(inRadius);
+
+		map.GetCentersInRange(range, result);
+		match = match && result.size() == inRange.size() && SumIndices(result) == SumIndices(inRange);
+
+		map.GetNearestCenters(position, nearestCount, result);
+		for (unsigned int k = 0; k < nearestCount; ++k)
+		{
+			match = match && result[k]->m_index == distances[k].second;
+		}
+	}
+
+	std::cout << "Spatial queries, " << centers.size() << " centers, " << QUERIES << " queries: radius " << radiusTime << " ms ("
+		<< radiusSum << " hits), range " << rangeTime << " ms (" << rangeSum << " hits), nearest " << nearestCount << " " << nearestTime << " ms"
+		<< (match ? "" : " (MISMATCH)") << std::endl;
+}
+
+void BenchmarkRaster(double pointSpread)
+{
+	Map map(WIDTH, HEIGHT, pointSpread, "benchmark");
+	map.Generate();
+
+	const unsigned int thumbnailWidth = 256, thumbnailHeight = 192;
+	MapRaster raster;
+	ThreadPool threadPool;
+
+	double fullTime = Measure([&]() { raster.Render(map, MapView::Biomes, WIDTH, HEIGHT); });
+	double parallelTime = Measure([&]() { raster.Render(map, MapView::Biomes, WIDTH, HEIGHT, &threadPool); });
+	double thumbnailTime = Measure([&]() { raster.Render(map, MapView::Biomes, thumbnailWidth, thumbnailHeight); });
+
+	std::cout << "Raster, " << map.GetMesh().GetCenterCount() << " centers: " << WIDTH << "x" << HEIGHT << " " << fullTime << " ms, "
+		<< threadPool.GetThreadCount() << " threads " << parallelTime << " ms, " << thumbnailWidth << "x" << thumbnailHeight << " " << thumbnailTime << " ms" << std::endl;
+}
+
+void BenchmarkRegeneration(double pointSpread)
+{
+	Map map(WIDTH, HEIGHT, pointSpread, "benchmark");
+	map.Generate();
+
+	// Alternates between two values so that every run has a change to apply
+	auto measureChange = [&map](const std::function<void(MapParameters&, bool)>& change)
+	{
+		bool toggle = false;
+
+		return Measure([&]()
+		{
+			MapParameters parameters = map.GetParameters();
+			change(parameters, toggle = !toggle);
+			map.SetParameters(parameters);
+			map.Generate();
+		});
+	};
+
+	double fullTime = Measure([&]()
+	{
+		Map fullMap(WIDTH, HEIGHT, pointSpread, "benchmark");
+		fullMap.Generate();
+	});
+	double landTime = measureChange([](MapParameters& parameters, bool toggle) { parameters.m_landFalloff = toggle ? 0.25 : 0.3; });
+	double riverTime = measureChange([](MapParameters& parameters, bool toggle) { parameters.m_centersPerRiver = toggle ? 2.0 : 3.0; });
+	double moistureTime = measureChange([](MapParameters& parameters, bool toggle) { parameters.m_freshwaterMoistureDecay = toggle ? 0.8 : 0.9; });
+	double biomeTime = measureChange([](MapParameters& parameters, bool toggle) { parameters.m_snowElevation = toggle ? 0.8 : 0.85; });
+
+	std::cout << "Regeneration, " << map.GetMesh().GetCenterCount() << " centers: full " << fullTime << " ms, land " << landTime
+		<< " ms, rivers " << riverTime << " ms, moisture " << moistureTime << " ms, biomes " << biomeTime << " ms" << std::endl;
+}
+
+// Without arguments, compares the current implementations with the previous ones.
+// With --stages [output.json] [minimum point spread], runs the stage suite and writes its JSON report.
+// With --check, runs the regression checks and returns non-zero if one fails.
+int main(int argc, char* argv[])
+{
+	if (argc > 1 && std::string(argv[1]) == "--check")
+	{
+		return RunRegressionCheck();
+	}
+
+	if (argc > 1 && std::string(argv[1]) == "--stages")
+	{
+		return RunStageBenchmark(argc > 2 ? argv[2] : "", argc > 3 ? std::stod(argv[3]) : 0.0);
+	}
+
+	const double pointSpreads[] = { 8.0, 4.0, 2.0 };
+
+	for (auto pointSpread : pointSpreads)
+	{
+		BenchmarkDualEdges(pointSpread);
+		BenchmarkRiverEdges(pointSpread);
+		BenchmarkSpatialQueries(pointSpread);
+		BenchmarkRaster(pointSpread);
+		BenchmarkRegeneration(pointSpread);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include <cstdio>
+#include <string>
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <iterator>
+#include <algorithm>
+#include <unordered_map>
+
+#include "RegressionCheck.h"
+#include "Map.h"
+#include "MapBatch.h"
+#include "MapInstrumentation.h"
+#include "MapFile.h"
+#include "Mesh.h"
+#include "World.h"
+
+namespace
+{
+	const int CHECK_WIDTH = 800;
+	const int CHECK_HEIGHT = 600;
+	const double CHECK_POINT_SPREAD = 10.0;
+
+	struct PinnedMap
+	{
+		const char* m_seed;
+		uint64_t m_graphHash;
+	};
+
+	// Hashes produced by a g++ x86-64 Linux build (glibc libm, libnoise built from its sources), not by the
+	// MSVC build of the solution. The point sampler calls cos and sin and the noise comes from libnoise,
+	// so another toolchain may give other hashes without any regression: re-pin them from the hashes printed
+	// by the first run there, keeping the second run and thread count checks as the determinism guard.
+	// A change that is meant to alter the maps must update these, any other change must leave them alone.
+	const PinnedMap PINNED_MAPS[] =
+	{
+		{ "hello", 0xfadf8d788380440cull },
+		{ "archipelago", 0x90acf28f429e4ccbull },
+		{ "0", 0x9f3731aa9fb91e9dull }
+	};
+
+	const unsigned int THREAD_COUNTS[] = { 2, 8 };
+
+	const unsigned int BATCH_THREAD_COUNT = 4;
+	const int BATCH_WIDTH = 400;
+	const int BATCH_HEIGHT = 300;
+	const double BATCH_POINT_SPREAD = 6.0;
+	// Request counts of the batches, in increasing order
+	const size_t BATCH_SIZES[] = { 8, 32, 128 };
+	// Peak memory the larger batches may add to the smallest one
+	const size_t MAX_BATCH_MEMORY_GROWTH = 32 * 1024 * 1024;
+
+	const char* ROUND_TRIP_PATH = "RegressionCheck.pmap";
+	const char* CORRUPT_PATH = "RegressionCheckCorrupt.pmap";
+
+	// Tiles of the seam check, 2 x 2 small tiles cover the same cells as one large tile
+	const unsigned int SMALL_TILE_CELLS = 32;
+	const unsigned int LARGE_TILE_CELLS = 2 * SMALL_TILE_CELLS;
+	const double WORLD_POINT_SPREAD = 10.0;
+	const char* WORLD_SEED = "seams";
+
+	uint64_t GenerateHash(const std::string& seed, unsigned int threadCount)
+	{
+		Map map(CHECK_WIDTH, CHECK_HEIGHT, CHECK_POINT_SPREAD, seed);
+		map.SetThreadCount(threadCount);
+		map.Generate();
+
+		return map.GetGraphHash();
+	}
+
+	bool Check(bool passed, const std::string& name, uint64_t expected, uint64_t actual)
+	{
+		printf("%s %s: expected %016llx, got %016llx\n", passed ? "ok  " : "FAIL", name.c_str(),
+			static_cast<unsigned long long>(expected), static_cast<unsigned long long>(actual));
+
+		return passed;
+	}
+
+	bool CheckThat(bool passed, const std::string& name)
+	{
+		printf("%s %s\n", passed ? "ok  " : "FAIL", name.c_str());
+
+		return passed;
+	}
+
+	bool CheckAtMost(const std::string& name, size_t limit, size_t actual)
+	{
+		printf("%s %s: at most %zu, got %zu\n", actual <= limit ? "ok  " : "FAIL", name.c_str(), limit, actual);
+
+		return actual <= limit;
+	}
+
+	// The maps in flight, and so the workspaces and the memory, must not grow with the request count.
+	// Peak memory only ever grows, so every batch is compared to the smallest one, run first.
+	bool CheckBatches()
+	{
+		bool passed = true;
+		size_t basePeakMemory = 0;
+
+		for (auto batchSize : BATCH_SIZES)
+		{
+			MapBatch batch(BATCH_THREAD_COUNT);
+			std::vector<MapRequest> requests;
+
+			for (size_t i = 0; i < batchSize; ++i)
+			{
+				requests.push_back({ BATCH_WIDTH, BATCH_HEIGHT, BATCH_POINT_SPREAD, std::to_string(i) });
+			}
+
+			batch.Generate(requests, [](size_t, std::unique_ptr<Map>) { });
+
+			size_t peakMemory = MapInstrumentation::GetPeakMemory();
+
+			if (basePeakMemory == 0)
+			{
+				basePeakMemory = peakMemory;
+			}
+
+			std::string name = "batch of " + std::to_string(batchSize);
+			passed &= CheckAtMost(name + ", workspaces", BATCH_THREAD_COUNT, batch.GetWorkspaceCount());
+			passed &= CheckAtMost(name + ", peak memory", basePeakMemory + MAX_BATCH_MEMORY_GROWTH, peakMemory);
+		}
+
+		return passed;
+	}
+
+	template <typename T, typename U>
+	bool IsEqual(Span<const T> span, const std::vector<U>& v)
+	{
+		return span.Size() == v.size() && std::equal(span.begin(), span.end(), v.begin());
+	}
+
+	bool IsEqual(const MapFileAdjacency& adjacency, const Adjacency& expected)
+	{
+		return IsEqual(adjacency.m_offsets, expected.m_offsets) && IsEqual(adjacency.m_indices, expected.m_indices);
+	}
+
+	// Writes bytes with the section entry of section changed by change
+	template <typename Change>
+	bool WriteCorrupted(const std::vector<char>& bytes, MapFileSection section, Change change)
+	{
+		std::vector<char> corrupted = bytes;
+		MapFileSectionEntry* entries = reinterpret_cast<MapFileSectionEntry*>(corrupted.data() + sizeof(MapFileHeader));
+		change(entries[static_cast<uint32_t>(section)], corrupted.data());
+
+		std::ofstream file(CORRUPT_PATH, std::ios::binary | std::ios::trunc);
+		file.write(corrupted.data(), corrupted.size());
+
+		return static_cast<bool>(file);
+	}
+
+	// A saved map must open to the same mesh and attributes, and files that do not match their header must not open
+	bool CheckRoundTrip()
+	{
+		Map map(CHECK_WIDTH, CHECK_HEIGHT, CHECK_POINT_SPREAD, PINNED_MAPS[0].m_seed);
+		map.Generate();
+
+		const Mesh& mesh = map.GetMesh();
+		const MapAttributes& attributes = map.GetAttributes();
+		bool passed = CheckThat(map.Save(ROUND_TRIP_PATH), "round trip, save");
+
+		MapFile mapFile;
+		passed &= CheckThat(mapFile.Open(ROUND_TRIP_PATH), "round trip, open");
+
+		if (mapFile.IsOpen())
+		{
+			const MapFileHeader& header = mapFile.GetHeader();
+			passed &= Check(header.m_graphHash == map.GetGraphHash(), "round trip, graph hash", map.GetGraphHash(), header.m_graphHash);
+			passed &= CheckThat(header.m_centerCount == mesh.GetCenterCount() && header.m_cornerCount == mesh.GetCornerCount() &&
+				header.m_edgeCount == mesh.GetEdgeCount(), "round trip, counts");
+			passed &= CheckThat(IsEqual(mapFile.GetCenterCenters(), mesh.m_centerCenters) && IsEqual(mapFile.GetCenterCorners(), mesh.m_centerCorners) &&
+				IsEqual(mapFile.GetCenterEdges(), mesh.m_centerEdges) && IsEqual(mapFile.GetCornerCorners(), mesh.m_cornerCorners) &&
+				IsEqual(mapFile.GetCornerCenters(), mesh.m_cornerCenters) && IsEqual(mapFile.GetCornerEdges(), mesh.m_cornerEdges) &&
+				IsEqual(mapFile.GetEdgeCenters(), mesh.m_edgeCenters) && IsEqual(mapFile.GetEdgeCorners(), mesh.m_edgeCorners), "round trip, mesh");
+			passed &= CheckThat(IsEqual(mapFile.GetCenterElevations(), attributes.m_centers.m_elevation) &&
+				IsEqual(mapFile.GetCenterMoistures(), attributes.m_centers.m_moisture) &&
+				IsEqual(mapFile.GetCornerElevations(), attributes.m_corners.m_elevation) &&
+				IsEqual(mapFile.GetCornerRiverVolumes(), attributes.m_corners.m_riverVolume) &&
+				IsEqual(mapFile.GetCornerDownslopes(), attributes.m_corners.m_downslope) &&
+				IsEqual(mapFile.GetEdgeRiverVolumes(), attributes.m_edges.m_riverVolume), "round trip, attributes");
+			mapFile.Close();
+		}
+
+		std::ifstream file(ROUND_TRIP_PATH, std::ios::binary);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		file.close();
+
+		passed &= CheckThat(WriteCorrupted(bytes, MapFileSection::EdgeCenters, [](MapFileSectionEntry& entry, char*) { entry.m_count /= 2; }) &&
+			!mapFile.Open(CORRUPT_PATH), "corrupt file, short section rejected");
+		passed &= CheckThat(WriteCorrupted(bytes, MapFileSection::CenterElevation, [](MapFileSectionEntry& entry, char*) { entry.m_elementSize = sizeof(float); }) &&
+			!mapFile.Open(CORRUPT_PATH), "corrupt file, element size rejected");
+		passed &= CheckThat(WriteCorrupted(bytes, MapFileSection::CornerCentersOffsets, [](MapFileSectionEntry& entry, char* data)
+			{
+				reinterpret_cast<uint32_t*>(data + entry.m_offset)[1] = Mesh::INVALID_INDEX;
+			}) && !mapFile.Open(CORRUPT_PATH), "corrupt file, offsets rejected");
+		passed &= CheckThat(WriteCorrupted(bytes, MapFileSection::CenterBiome, [](MapFileSectionEntry& entry, char* data)
+			{
+				data[entry.m_offset] = static_cast<char>(static_cast<uint8_t>(BiomeType::None) + 1);
+			}) && !mapFile.Open(CORRUPT_PATH), "corrupt file, biome rejected");
+		passed &= CheckThat(WriteCorrupted(bytes, MapFileSection::CenterBiome, [](MapFileSectionEntry& entry, char* data)
+			{
+				data[entry.m_offset] = static_cast<char>(BiomeType::None);
+			}) && mapFile.Open(CORRUPT_PATH), "file with BiomeType::None accepted");
+		mapFile.Close();
+
+		remove(ROUND_TRIP_PATH);
+		remove(CORRUPT_PATH);
+
+		return passed;
+	}
+
+	// A corner must come out the same whichever tile generates it, so the corners of 2 x 2 small tiles
+	// must all be found in the large tile over the same cells, with the same position and attributes
+	bool CheckWorldSeams()
+	{
+		World smallWorld(SMALL_TILE_CELLS, WORLD_POINT_SPREAD, WORLD_SEED);
+		World largeWorld(LARGE_TILE_CELLS, WORLD_POINT_SPREAD, WORLD_SEED);
+		std::unique_ptr<WorldTile> largeTile = largeWorld.GenerateTile(0, 0);
+
+		std::unordered_map<uint64_t, unsigned int> largeCorners;
+
+		for (unsigned int c = 0; c < largeTile->m_cornerIds.size(); ++c)
+		{
+			largeCorners[largeTile->m_cornerIds[c]] = c;
+		}
+
+		const Mesh& largeMesh = largeTile->m_mesh;
+		const CornerAttributes& largeAttributes = largeTile->m_attributes.m_corners;
+		size_t cornerCount = 0;
+		size_t missingCount = 0;
+		size_t mismatchCount = 0;
+
+		for (int y = 0; y < 2; ++y)
+		{
+			for (int x = 0; x < 2; ++x)
+			{
+				std::unique_ptr<WorldTile> tile = smallWorld.GenerateTile(x, y);
+				const Mesh& mesh = tile->m_mesh;
+				const CornerAttributes& attributes = tile->m_attributes.m_corners;
+
+				for (unsigned int c = 0; c < tile->m_cornerIds.size(); ++c)
+				{
+					auto corner = largeCorners.find(tile->m_cornerIds[c]);
+					++cornerCount;
+
+					if (corner == largeCorners.end())
+					{
+						++missingCount;
+						continue;
+					}
+
+					unsigned int l = corner->second;
+
+					if (mesh.m_cornerPositions[c].x != largeMesh.m_cornerPositions[l].x || mesh.m_cornerPositions[c].y != largeMesh.m_cornerPositions[l].y ||
+						attributes.m_elevation[c] != largeAttributes.m_elevation[l] || attributes.m_moisture[c] != largeAttributes.m_moisture[l] ||
+						attributes.m_riverVolume[c] != largeAttributes.m_riverVolume[l])
+					{
+						++mismatchCount;
+					}
+				}
+			}
+		}
+
+		bool passed = CheckThat(cornerCount > 0, "world seams, " + std::to_string(cornerCount) + " corners");
+		passed &= CheckAtMost("world seams, corners missing from the large tile", 0, missingCount);
+		passed &= CheckAtMost("world seams, corners that differ from the large tile", 0, mismatchCount);
+
+		return passed;
+	}
+}
+
+int RunRegressionCheck()
+{
+	// Before the single maps, whose memory would hide the growth of the batches
+	bool passed = CheckBatches();
+	bool pinnedPassed = true;
+
+	for (const auto& pinned : PINNED_MAPS)
+	{
+		std::string seed = pinned.m_seed;
+		uint64_t hash = GenerateHash(seed, 1);
+		uint64_t secondHash = GenerateHash(seed, 1);
+
+		passed &= Check(secondHash == hash, "seed " + seed + ", second run", hash, secondHash);
+
+		for (auto threadCount : THREAD_COUNTS)
+		{
+			uint64_t threadedHash = GenerateHash(seed, threadCount);
+			passed &= Check(threadedHash == hash, "seed " + seed + ", " + std::to_string(threadCount) + " threads", hash, threadedHash);
+		}
+
+		pinnedPassed &= Check(hash == pinned.m_graphHash, "seed " + seed + ", pinned hash", pinned.m_graphHash, hash);
+	}
+
+	passed &= pinnedPassed;
+
+	if (!pinnedPassed)
+	{
+		printf("The pinned hashes come from a g++ x86-64 Linux build, see PINNED_MAPS before taking a mismatch for a regression\n");
+	}
+
+	passed &= CheckRoundTrip();
+	passed &= CheckWorldSeams();
+
+	printf(passed ? "All checks passed\n" : "Some checks failed\n");
+
+	return passed ? 0 : 1;
+}
\ No newline at end of file
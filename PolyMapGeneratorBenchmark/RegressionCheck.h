@@ -0,0 +1,12 @@
+#ifndef REGRESSION_CHECK_H
+#define REGRESSION_CHECK_H
+
+// Checks that map generation is deterministic: the graph hash of a seed must not change between runs
+// or thread counts, and must match the hashes pinned for a few fixed seeds.
+// Also checks that a saved map opens to the same mesh and attributes, that corrupt map files are rejected,
+// that the workspaces and peak memory of a batch do not grow with its request count,
+// and that world tiles agree on the corners they share with a larger tile over the same cells.
+// Prints one line per check and returns 0 if all of them pass, 1 otherwise.
+int RunRegressionCheck();
+
+#endif
\ No newline at end of file
@@ -0,0 +1,425 @@
+#include <cmath>
+#include <memory>
+#include <random>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <functional>
+#include <SFML/System.hpp>
+
+#include "AllocationCounter.h"
+#include "StageBenchmark.h"
+#include "DelaunayTriangulation.h"
+#include "Map.h"
+#include "Structure.h"
+#include "Math/AABB.h"
+#include "PoissonDiskSampling/PoissonDiskSampling.h"
+
+namespace
+{
+	// Large enough for a million cells at the smallest spread, since sites have integer coordinates
+	const int STAGE_WIDTH = 3200;
+	const int STAGE_HEIGHT = 2400;
+	const int STAGE_QUERIES = 10000;
+	const unsigned int NEAREST_COUNT = 8;
+
+	struct BenchmarkSize
+	{
+		double m_pointSpread;
+		int m_runs;
+	};
+
+	// About 1k, 4k, 17k, 70k, 280k and 1.1M cells, with fewer runs as the maps grow
+	const BenchmarkSize SIZES[] =
+	{
+		{ 64.0, 9 },
+		{ 32.0, 9 },
+		{ 16.0, 7 },
+		{ 8.0, 5 },
+		{ 4.0, 3 },
+		{ 2.0, 1 }
+	};
+
+	struct StageResult
+	{
+		std::string m_name;
+		std::vector<double> m_times;
+		// Of the first run, the later runs allocate the same
+		bool m_hasAllocations;
+		AllocationCount m_allocations;
+	};
+
+	struct SizeResult
+	{
+		double m_pointSpread;
+		int m_runs;
+		unsigned int m_centerCount;
+		unsigned int m_cornerCount;
+		unsigned int m_edgeCount;
+		std::vector<StageResult> m_stages;
+		// Of the first run of Map::Generate
+		uint64_t m_counters[static_cast<size_t>(MapCounter::Size)];
+		size_t m_peakMemory;
+	};
+
+	// Counts the allocations of every stage of Map::Generate, which only holds with a single thread,
+	// since the allocation counter is shared by the whole process
+	class StageRecorder : public MapInstrumentation
+	{
+	public:
+		StageRecorder() : m_peakMemory(0), m_begin({ 0, 0 })
+		{
+			std::fill(m_counters, m_counters + static_cast<size_t>(MapCounter::Size), 0);
+		}
+
+		~StageRecorder() = default;
+
+		void BeginStage(const std::string& /*name*/) override
+		{
+			m_begin = GetAllocationCount();
+		}
+
+		void EndStage(const std::string& name, double /*time*/) override
+		{
+			AllocationCount end = GetAllocationCount();
+			m_allocations.push_back(std::make_pair(name, AllocationCount { end.m_allocations - m_begin.m_allocations, end.m_bytes - m_begin.m_bytes }));
+		}
+
+		void AddCount(MapCounter counter, uint64_t value) override
+		{
+			m_counters[static_cast<size_t>(counter)] += value;
+		}
+
+		void SetPeakMemory(size_t bytes) override
+		{
+			m_peakMemory = std::max(m_peakMemory, bytes);
+		}
+
+		std::vector<std::pair<std::string, AllocationCount>> m_allocations;
+		uint64_t m_counters[static_cast<size_t>(MapCounter::Size)];
+		size_t m_peakMemory;
+
+	private:
+		AllocationCount m_begin;
+	};
+
+	double GetMedian(std::vector<double> times)
+	{
+		std::sort(times.begin(), times.end());
+
+		return times.empty() ? 0.0 : times[times.size() / 2];
+	}
+
+	StageResult& GetStage(std::vector<StageResult>& stages, const std::string& name)
+	{
+		for (auto& stage : stages)
+		{
+			if (stage.m_name == name)
+			{
+				return stage;
+			}
+		}
+
+		stages.push_back({ name, std::vector<double>(), false, { 0, 0 } });
+
+		return stages.back();
+	}
+
+	// Runs function, adds its time to the stage and, on the first run, its allocations
+	void MeasureStage(std::vector<StageResult>& stages, const std::string& name, const std::function<void()>& function)
+	{
+		StageResult& stage = GetStage(stages, name);
+		AllocationCount before = GetAllocationCount();
+		sf::Clock timer;
+
+		function();
+
+		double time = timer.getElapsedTime().asMicroseconds() / 1000.0;
+		AllocationCount after = GetAllocationCount();
+
+		if (stage.m_times.empty())
+		{
+			stage.m_hasAllocations = true;
+			stage.m_allocations = { after.m_allocations - before.m_allocations, after.m_bytes - before.m_bytes };
+		}
+
+		stage.m_times.push_back(time);
+	}
+
+	// Exponent b of time = a * cells^b, least squares on the logarithms
+	double FitExponent(const std::vector<std::pair<double, double>>& points)
+	{
+		double sumX = 0.0, sumY = 0.0, sumXX = 0.0, sumXY = 0.0;
+		double count = 0.0;
+
+		for (const auto& point : points)
+		{
+			if (point.first <= 0.0 || point.second <= 0.0)
+			{
+				continue;
+			}
+
+			double x = log(point.first);
+			double y = log(point.second);
+			sumX += x;
+			sumY += y;
+			sumXX += x * x;
+			sumXY += x * y;
+			count += 1.0;
+		}
+
+		double denominator = count * sumXX - sumX * sumX;
+
+		return count >= 2.0 && denominator != 0.0 ? (count * sumXY - sumX * sumY) / denominator : 0.0;
+	}
+
+	SizeResult RunSize(const BenchmarkSize& size)
+	{
+		SizeResult result = { size.m_pointSpread, size.m_runs, 0, 0, 0, std::vector<StageResult>(), { }, 0 };
+		std::unique_ptr<Map> map;
+		StageRecorder recorder;
+
+		for (int run = 0; run < size.m_runs; ++run)
+		{
+			// The previous map is released first, so that the largest size only holds one
+			map.reset();
+			map.reset(new Map(STAGE_WIDTH, STAGE_HEIGHT, size.m_pointSpread, "benchmark"));
+			// One thread, so that the stages of the task graph do not overlap
+			map->SetThreadCount(1);
+			map->SetInstrumentation(run == 0 ? &recorder : nullptr);
+
+			MeasureStage(result.m_stages, "Generate", [&map]() { map->Generate(); });
+
+			for (const auto& stageTime : map->GetStageTimes())
+			{
+				GetStage(result.m_stages, stageTime.m_name).m_times.push_back(stageTime.m_time);
+			}
+		}
+
+		for (const auto& allocations : recorder.m_allocations)
+		{
+			StageResult& stage = GetStage(result.m_stages, allocations.first);
+			stage.m_hasAllocations = true;
+			stage.m_allocations = allocations.second;
+		}
+
+		std::copy(recorder.m_counters, recorder.m_counters + static_cast<size_t>(MapCounter::Size), result.m_counters);
+		result.m_peakMemory = recorder.m_peakMemory;
+
+		result.m_centerCount = map->GetMesh().GetCenterCount();
+		result.m_cornerCount = map->GetMesh().GetCornerCount();
+		result.m_edgeCount = map->GetMesh().GetEdgeCount();
+
+		// The two standalone kernels, so that their allocations are counted apart from the rest of Map::Generate
+		std::vector<DelaunayTriangulation::Vertex> sites;
+
+		for (int run = 0; run < size.m_runs; ++run)
+		{
+			std::vector<std::pair<double, double>> points;
+			PoissonDiskSampling pds(STAGE_WIDTH, STAGE_HEIGHT, size.m_pointSpread, 10);
+
+			MeasureStage(result.m_stages, "Poisson sampling", [&]() { points = pds.Generate(0, 1); });
+
+			sites.clear();
+			for (auto point : points)
+			{
+				sites.push_back(DelaunayTriangulation::Vertex(static_cast<int>(point.first), static_cast<int>(point.second)));
+			}
+		}
+
+		std::sort(sites.begin(), sites.end());
+		sites.erase(std::unique(sites.begin(), sites.end()), sites.end());
+
+		for (int run = 0; run < size.m_runs; ++run)
+		{
+			std::vector<unsigned int> triangles;
+			std::vector<unsigned int> halfEdges;
+			DelaunayTriangulation::Delaunay delaunay;
+
+			MeasureStage(result.m_stages, "Delaunay triangulation", [&]() { delaunay.Triangulate(sites, triangles, halfEdges); });
+		}
+
+		// Queries on the quadtree built by the last map, from the same positions every run
+		std::mt19937 mt_rand(0);
+		std::uniform_real_distribution<double> xDistribution(0.0, STAGE_WIDTH);
+		std::uniform_real_distribution<double> yDistribution(0.0, STAGE_HEIGHT);
+		std::vector<Vector2> positions;
+
+		for (int i = 0; i < STAGE_QUERIES; ++i)
+		{
+			double x = xDistribution(mt_rand);
+			positions.push_back(Vector2(x, yDistribution(mt_rand)));
+		}
+
+		std::vector<Center*> centers;
+		double radius = 4 * size.m_pointSpread;
+
+		for (int run = 0; run < size.m_runs; ++run)
+		{
+			MeasureStage(result.m_stages, "Quadtree radius query", [&]()
+			{
+				for (const auto& position : positions)
+				{
+					map->GetCentersInRadius(position, radius, centers);
+				}
+			});
+
+			MeasureStage(result.m_stages, "Quadtree range query", [&]()
+			{
+				for (const auto& position : positions)
+				{
+					map->GetCentersInRange(AABB(position, Vector2(radius, radius)), centers);
+				}
+			});
+
+			MeasureStage(result.m_stages, "Quadtree nearest query", [&]()
+			{
+				for (const auto& position : positions)
+				{
+					map->GetNearestCenters(position, NEAREST_COUNT, centers);
+				}
+			});
+		}
+
+		return result;
+	}
+
+	void WriteStage(std::ostream& out, const StageResult& stage)
+	{
+		std::vector<double> sorted = stage.m_times;
+		std::sort(sorted.begin(), sorted.end());
+
+		out << "        { \"name\": \"" << stage.m_name << "\", \"median_ms\": " << GetMedian(sorted)
+			<< ", \"min_ms\": " << sorted.front() << ", \"max_ms\": " << sorted.back();
+
+		if (stage.m_hasAllocations)
+		{
+			out << ", \"allocations\": " << stage.m_allocations.m_allocations << ", \"allocated_bytes\": " << stage.m_allocations.m_bytes;
+		}
+
+		out << " }";
+	}
+
+	void WriteResults(std::ostream& out, const std::vector<SizeResult>& results)
+	{
+		out << "{\n";
+		out << "  \"benchmark\": \"stages\",\n";
+		out << "  \"width\": " << STAGE_WIDTH << ",\n";
+		out << "  \"height\": " << STAGE_HEIGHT << ",\n";
+		out << "  \"threads\": 1,\n";
+		out << "  \"queries\": " << STAGE_QUERIES << ",\n";
+		out << "  \"sizes\": [\n";
+
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const SizeResult& result = results[i];
+
+			out << "    {\n";
+			out << "      \"point_spread\": " << result.m_pointSpread << ",\n";
+			out << "      \"runs\": " << result.m_runs << ",\n";
+			out << "      \"centers\": " << result.m_centerCount << ",\n";
+			out << "      \"corners\": " << result.m_cornerCount << ",\n";
+			out << "      \"edges\": " << result.m_edgeCount << ",\n";
+			out << "      \"counters\": {";
+
+			for (size_t counter = 0; counter < static_cast<size_t>(MapCounter::Size); ++counter)
+			{
+				out << (counter > 0 ? ", " : " ") << "\"" << GetCounterName(static_cast<MapCounter>(counter)) << "\": " << result.m_counters[counter];
+			}
+
+			out << " },\n";
+			out << "      \"peak_memory_bytes\": " << result.m_peakMemory << ",\n";
+			out << "      \"stages\": [\n";
+
+			for (size_t j = 0; j < result.m_stages.size(); ++j)
+			{
+				WriteStage(out, result.m_stages[j]);
+				out << (j + 1 < result.m_stages.size() ? ",\n" : "\n");
+			}
+
+			out << "      ]\n";
+			out << "    }" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+
+		out << "  ],\n";
+
+		// Median time of every stage against the number of centers, in the order the stages first appear
+		std::vector<std::string> names;
+
+		for (const auto& result : results)
+		{
+			for (const auto& stage : result.m_stages)
+			{
+				if (std::find(names.begin(), names.end(), stage.m_name) == names.end())
+				{
+					names.push_back(stage.m_name);
+				}
+			}
+		}
+
+		out << "  \"scaling\": [\n";
+
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			std::vector<std::pair<double, double>> points;
+
+			for (const auto& result : results)
+			{
+				for (const auto& stage : result.m_stages)
+				{
+					if (stage.m_name == names[i])
+					{
+						points.push_back(std::make_pair(static_cast<double>(result.m_centerCount), GetMedian(stage.m_times)));
+					}
+				}
+			}
+
+			out << "    { \"name\": \"" << names[i] << "\", \"exponent\": " << FitExponent(points) << ", \"points\": [";
+
+			for (size_t j = 0; j < points.size(); ++j)
+			{
+				out << (j > 0 ? ", " : "") << "[" << points[j].first << ", " << points[j].second << "]";
+			}
+
+			out << "] }" << (i + 1 < names.size() ? ",\n" : "\n");
+		}
+
+		out << "  ]\n";
+		out << "}\n";
+	}
+}
+
+int RunStageBenchmark(const std::string& outputPath, double minPointSpread)
+{
+	std::vector<SizeResult> results;
+
+	for (const auto& size : SIZES)
+	{
+		if (size.m_pointSpread < minPointSpread)
+		{
+			continue;
+		}
+
+		// Progress goes to stderr, so that stdout only holds the JSON
+		std::cerr << "Stages, point spread " << size.m_pointSpread << "..." << std::endl;
+		results.push_back(RunSize(size));
+	}
+
+	if (outputPath.empty())
+	{
+		WriteResults(std::cout, results);
+		return 0;
+	}
+
+	std::ofstream file(outputPath);
+
+	if (!file)
+	{
+		std::cerr << "Cannot write " << outputPath << std::endl;
+		return 1;
+	}
+
+	WriteResults(file, results);
+
+	return file.good() ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef STAGE_BENCHMARK_H
+#define STAGE_BENCHMARK_H
+
+#include <string>
+
+// Times every generation stage on maps from about a thousand to about a million cells
+// and writes the medians, the allocations and a scaling fit of every stage as JSON, with the counters and the peak memory of every size.
+// Writes to stdout if outputPath is empty, sizes with a point spread under minPointSpread are skipped.
+// Returns the exit code of the benchmark.
+int RunStageBenchmark(const std::string& outputPath, double minPointSpread);
+
+#endif
\ No newline at end of file
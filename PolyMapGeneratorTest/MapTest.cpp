@@ -3,124 +3,51 @@
 #include <SFML/Window.hpp>
 
 #include "Map.h"
+#include "MapPalette.h"
 #include "Structure.h"
-#include "ConvexHull.h"
 
 const int WIDTH = 800;
 const int HEIGHT = 600;
 
-const int POINT_SIZE = 0;
-const int LINE_SIZE = 1;
+MapView VideoMode;
 
-struct InfoShown
-{
-	enum class Name
-	{
-		Elevation,
-		Moisture,
-		Biomes
-	};
-};
-
-InfoShown::Name VideoMode;
-
-sf::Color DELAUNAY_COLOR = sf::Color::Black;
-sf::Color VORONOI_COLOR = sf::Color(sf::Uint8(52), sf::Uint8(58), sf::Uint8(94), sf::Uint8(127));
-sf::Color WATER_COLOR = sf::Color(sf::Uint8(52), sf::Uint8(58), sf::Uint8(94));
-sf::Color LAND_COLOR = sf::Color(sf::Uint8(178), sf::Uint8(166), sf::Uint8(148));
-sf::Color LAKE_COLOR = sf::Color(sf::Uint8(95), sf::Uint8(134), sf::Uint8(169));
-sf::Color RIVER_COLOR = sf::Color(sf::Uint8(40), sf::Uint8(88), sf::Uint8(132));
-
-const sf::Color ELEVATION_COLOR[] =
-{
-	sf::Color(sf::Uint8(104), sf::Uint8(134), sf::Uint8(89)),
-	sf::Color(sf::Uint8(119), sf::Uint8(153), sf::Uint8(102)),
-	sf::Color(sf::Uint8(136), sf::Uint8(166), sf::Uint8(121)),
-	sf::Color(sf::Uint8(153), sf::Uint8(179), sf::Uint8(148)),
-	sf::Color(sf::Uint8(170), sf::Uint8(191), sf::Uint8(159)),
-	sf::Color(sf::Uint8(187), sf::Uint8(204), sf::Uint8(179)),
-	sf::Color(sf::Uint8(204), sf::Uint8(217), sf::Uint8(198)),
-	sf::Color(sf::Uint8(221), sf::Uint8(230), sf::Uint8(217)),
-	sf::Color(sf::Uint8(238), sf::Uint8(242), sf::Uint8(236)),
-	sf::Color(sf::Uint8(251), sf::Uint8(252), sf::Uint8(251))
-};
-
-const sf::Color MOISTURE_COLOR[] =
-{
-	sf::Color(sf::Uint8(238), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(218), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(197), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(176), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(155), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(135), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(115), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(94), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(73), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(52), sf::Uint8(238), sf::Uint8(32)),
-	sf::Color(sf::Uint8(32), sf::Uint8(238), sf::Uint8(32))
-};
-
-const sf::Color BIOME_COLOR[] =
-{
-	sf::Color(sf::Uint8(248), sf::Uint8(248), sf::Uint8(248)),
-	sf::Color(sf::Uint8(221), sf::Uint8(221), sf::Uint8(187)),
-	sf::Color(sf::Uint8(153), sf::Uint8(153), sf::Uint8(153)),
-	sf::Color(sf::Uint8(204), sf::Uint8(212), sf::Uint8(187)),
-	sf::Color(sf::Uint8(196), sf::Uint8(204), sf::Uint8(187)),
-	sf::Color(sf::Uint8(228), sf::Uint8(232), sf::Uint8(202)),
-	sf::Color(sf::Uint8(164), sf::Uint8(196), sf::Uint8(168)),
-	sf::Color(sf::Uint8(180), sf::Uint8(201), sf::Uint8(169)),
-	sf::Color(sf::Uint8(196), sf::Uint8(212), sf::Uint8(170)),
-	sf::Color(sf::Uint8(156), sf::Uint8(187), sf::Uint8(169)),
-	sf::Color(sf::Uint8(169), sf::Uint8(204), sf::Uint8(164)),
-	sf::Color(sf::Uint8(233), sf::Uint8(221), sf::Uint8(199)),
-	sf::Color(sf::Uint8(52), sf::Uint8(58), sf::Uint8(94)),
-	sf::Color(sf::Uint8(95), sf::Uint8(134), sf::Uint8(169)),
-	sf::Color(sf::Uint8(178), sf::Uint8(166), sf::Uint8(148))
-};
-
-void DrawLine(Vector2 a, Vector2 b, double width, sf::Color c, sf::RenderWindow* window);
-void DrawEdge(Edge* e, sf::RenderWindow* window);
-void DrawCorner(Corner* c, sf::RenderWindow* window);
-void DrawCenter(Center* c, sf::RenderWindow* window);
+sf::Color ToColor(const MapColor& color);
+void BuildCells(const std::vector<Center*>& centers, sf::VertexArray& cells, std::vector<unsigned int>& cellOffsets);
+void ColorCells(const std::vector<Center*>& centers, const std::vector<unsigned int>& cellOffsets, sf::VertexArray& cells);
+void BuildEdges(const std::vector<Edge*>& edges, sf::VertexArray& lines);
+void AppendLine(Vector2 a, Vector2 b, double width, sf::Color c, sf::VertexArray& lines);
 
 int main()
 {
 	sf::Clock timer;
 
-	VideoMode = InfoShown::Name::Biomes;
+	VideoMode = MapView::Biomes;
 
 	sf::RenderWindow* app = new sf::RenderWindow(sf::VideoMode(WIDTH, HEIGHT, 32), "Map Generator", sf::Style::Default, sf::ContextSettings(24, 8, 8, 3, 3));
 	app->setFramerateLimit(60);
 
 	Map map(WIDTH, HEIGHT, 10, "");
+	map.SetVerbose(true);
+	MapSummaryTable summary;
+	map.SetInstrumentation(&summary);
 
 	timer.restart();
 	map.Generate();
 	std::cout << timer.getElapsedTime().asMicroseconds() / 1000.0 << std::endl;
+	summary.Print(std::cout);
 
 	std::vector<Edge*> edges = map.GetEdges();
-	std::vector<Corner*> corners = map.GetCorners();
 	std::vector<Center*> centers = map.GetCenters();
 
-	std::vector<sf::ConvexShape> polygons;
-	for (auto center : centers)
-	{
-		sf::ConvexShape polygon;
-		polygon.setPointCount(center->m_corners.size());
-
-		for (size_t i = 0; i < center->m_corners.size(); ++i)
-		{
-			Vector2 aux = center->m_corners[i]->m_position;
-			polygon.setPoint(i, sf::Vector2f(static_cast<float>(aux.x), static_cast<float>(aux.y)));
-		}
-
-		polygon.setFillColor(BIOME_COLOR[static_cast<int>(center->m_biome)]);
-		polygon.setPosition(0, 0);
-		polygons.push_back(polygon);
-	}
+	// Geometry is built once per map, a view mode change only rewrites the cell colors
+	sf::VertexArray cells(sf::Triangles);
+	sf::VertexArray lines(sf::Quads);
+	sf::VertexArray selection(sf::Triangles);
+	std::vector<unsigned int> cellOffsets;
 
-	Center* selectedCenter = nullptr;
+	BuildCells(centers, cells, cellOffsets);
+	ColorCells(centers, cellOffsets, cells);
+	BuildEdges(edges, lines);
 
 	bool running = true;
 	while (running)
@@ -135,6 +62,7 @@ int main()
 			else if (event.type == sf::Event::KeyPressed)
 			{
 				sf::Image screen;
+				MapView previousMode = VideoMode;
 
 				switch (event.key.code)
 				{
@@ -142,13 +70,13 @@ int main()
 					running = false;
 					break;
 				case sf::Keyboard::M:
-					VideoMode = InfoShown::Name::Moisture;
+					VideoMode = MapView::Moisture;
 					break;
 				case sf::Keyboard::B:
-					VideoMode = InfoShown::Name::Biomes;
+					VideoMode = MapView::Biomes;
 					break;
 				case sf::Keyboard::E:
-					VideoMode = InfoShown::Name::Elevation;
+					VideoMode = MapView::Elevation;
 					break;
 				case sf::Keyboard::F12:
 					screen = app->capture();
@@ -157,182 +85,126 @@ int main()
 				default:
 					break;
 				}
+
+				if (VideoMode != previousMode)
+				{
+					ColorCells(centers, cellOffsets, cells);
+				}
 			}
 			else if (event.type == sf::Event::MouseButtonPressed)
 			{
 				if (event.mouseButton.button == sf::Mouse::Button::Left)
 				{
-					timer.restart();
-					selectedCenter = map.GetCenterAt(Vector2(event.mouseButton.x, event.mouseButton.y));
+					Center* selectedCenter = map.GetCenterAt(Vector2(event.mouseButton.x, event.mouseButton.y));
+					std::vector<unsigned int> selectionOffsets;
+
+					selection.clear();
+
+					if (selectedCenter != nullptr)
+					{
+						BuildCells(std::vector<Center*>(1, selectedCenter), selection, selectionOffsets);
+
+						for (size_t i = 0; i < selection.getVertexCount(); ++i)
+						{
+							selection[i].color = sf::Color::Black;
+						}
+					}
 				}
 			}
 		}
 
 		app->clear(sf::Color::White);
+		app->draw(cells);
+		app->draw(lines);
+		app->draw(selection);
+		app->display();
+	}
 
-		if (!centers.empty())
-		{
-			timer.restart();
+	return 0;
+}
 
-			for (auto center : centers)
-			{
-				DrawCenter(center, app);
-			}
-		}
+sf::Color ToColor(const MapColor& color)
+{
+	return sf::Color(color.r, color.g, color.b, color.a);
+}
 
-		if (!edges.empty())
-		{
-			for (auto edge : edges)
-			{
-				DrawEdge(edge, app);
-			}
-		}
+// Appends every polygon as a fan of triangles from its first corner,
+// the vertices of center i are cells[cellOffsets[i]] ... cells[cellOffsets[i + 1] - 1]
+void BuildCells(const std::vector<Center*>& centers, sf::VertexArray& cells, std::vector<unsigned int>& cellOffsets)
+{
+	cellOffsets.assign(1, static_cast<unsigned int>(cells.getVertexCount()));
 
-		if (!corners.empty())
+	for (auto center : centers)
+	{
+		// The corners were put in polygon order when the map was built
+		if (!center->m_cornersSorted)
 		{
-			for (auto corner : corners)
-			{
-				DrawCorner(corner, app);
-			}
+			center->SortCorners();
 		}
 
-		if (selectedCenter != nullptr)
+		for (size_t i = 2; i < center->m_corners.size(); ++i)
 		{
-			sf::ConvexShape polygon;
-			polygon.setPointCount(selectedCenter->m_corners.size());
+			Vector2 triangle[3] = { center->m_corners[0]->m_position, center->m_corners[i - 1]->m_position, center->m_corners[i]->m_position };
 
-			ConvexHull::CalculateConvexHull(selectedCenter->m_corners);
-
-			for (size_t i = 0; i < selectedCenter->m_corners.size(); ++i)
+			for (auto position : triangle)
 			{
-				Vector2 aux = selectedCenter->m_corners[i]->m_position;
-				polygon.setPoint(i, sf::Vector2f(static_cast<float>(aux.x), static_cast<float>(aux.y)));
+				cells.append(sf::Vertex(sf::Vector2f(static_cast<float>(position.x), static_cast<float>(position.y))));
 			}
-
-			polygon.setFillColor(sf::Color::Black);
-			polygon.setPosition(0, 0);
-			polygons.push_back(polygon);
-			app->draw(polygon);
 		}
 
-		app->display();
+		cellOffsets.push_back(static_cast<unsigned int>(cells.getVertexCount()));
 	}
-
-	return 0;
 }
 
-void DrawLine(Vector2 a, Vector2 b, double width, sf::Color c, sf::RenderWindow* window)
+void ColorCells(const std::vector<Center*>& centers, const std::vector<unsigned int>& cellOffsets, sf::VertexArray& cells)
 {
-	Vector2 lineVector(a, b);
-	sf::RectangleShape line(sf::Vector2f(static_cast<float>(lineVector.Length()), static_cast<float>(width)));
-
-	line.setFillColor(c);
-	line.setRotation(static_cast<float>(lineVector.GetAngleByDegree()));
-	line.setPosition(static_cast<float>(a.x), static_cast<float>(a.y));
-
-	window->draw(line);
-}
-
-void DrawEdge(Edge* e, sf::RenderWindow* window)
-{
-	Vector2 v0;
-	if (e->m_v0 == nullptr)
+	for (size_t i = 0; i < centers.size(); ++i)
 	{
-		v0 = (e->m_d0->m_position + e->m_d1->m_position) / 2;
-	}
-	else
-	{
-		v0 = e->m_v0->m_position;
-	}
-
-	Vector2 v1;
-	if (e->m_v1 == nullptr)
-	{
-		v1 = (e->m_d0->m_position + e->m_d1->m_position) / 2;
-	}
-	else
-	{
-		v1 = e->m_v1->m_position;
-	}
+		const Center* center = centers[i];
+		sf::Color color = ToColor(MapPalette::GetCenterColor(VideoMode, center->m_biome, center->m_elevation, center->m_moisture, center->m_water, center->m_ocean));
 
-	if (e->m_riverVolume > 0)
-	{
-		DrawLine(v0, v1, 1 + sqrt(e->m_riverVolume), RIVER_COLOR, window);
-	}
-	else
-	{
-		DrawLine(v0, v1, 1, VORONOI_COLOR, window);
+		for (unsigned int vertex = cellOffsets[i]; vertex < cellOffsets[i + 1]; ++vertex)
+		{
+			cells[vertex].color = color;
+		}
 	}
 }
 
-void DrawCorner(Corner* c, sf::RenderWindow* window)
+void BuildEdges(const std::vector<Edge*>& edges, sf::VertexArray& lines)
 {
-	sf::CircleShape point;
-
-	if (c->m_water)
+	for (auto e : edges)
 	{
-		point.setFillColor(WATER_COLOR);
-	}
-	else
-	{
-		point.setFillColor(LAND_COLOR);
-	}
+		Vector2 midpoint = (e->m_d0->m_position + e->m_d1->m_position) / 2;
+		Vector2 v0 = e->m_v0 != nullptr ? e->m_v0->m_position : midpoint;
+		Vector2 v1 = e->m_v1 != nullptr ? e->m_v1->m_position : midpoint;
 
-	point.setPosition(static_cast<float>(c->m_position.x - POINT_SIZE), static_cast<float>(c->m_position.y - POINT_SIZE));
-	point.setRadius(static_cast<float>(POINT_SIZE));
-	window->draw(point);
+		if (e->m_riverVolume > 0)
+		{
+			AppendLine(v0, v1, 1 + sqrt(e->m_riverVolume), ToColor(MapPalette::RIVER), lines);
+		}
+		else
+		{
+			AppendLine(v0, v1, 1, ToColor(MapPalette::VORONOI), lines);
+		}
+	}
 }
 
-void DrawCenter(Center* c, sf::RenderWindow* window)
+// Same rectangle as a rotated sf::RectangleShape placed at a, as one quad
+void AppendLine(Vector2 a, Vector2 b, double width, sf::Color c, sf::VertexArray& lines)
 {
-	sf::ConvexShape polygon;
-	polygon.setPointCount(c->m_corners.size());
-
-	ConvexHull::CalculateConvexHull(c->m_corners);
+	Vector2 lineVector(a, b);
+	double length = lineVector.Length();
 
-	for (size_t i = 0; i < c->m_corners.size(); ++i)
+	if (length <= 0.0)
 	{
-		Vector2 aux = c->m_corners[i]->m_position;
-		polygon.setPoint(i, sf::Vector2f(static_cast<float>(aux.x), static_cast<float>(aux.y)));
+		return;
 	}
 
-	switch (VideoMode)
+	Vector2 side(-lineVector.y * width / length, lineVector.x * width / length);
+	Vector2 quad[4] = { a, b, b + side, a + side };
+
+	for (auto position : quad)
 	{
-	case InfoShown::Name::Biomes:
- 		polygon.setFillColor(BIOME_COLOR[static_cast<int>(c->m_biome)]);
-		break;
-	case InfoShown::Name::Elevation:
-		if (c->m_ocean)
-		{
-			polygon.setFillColor(WATER_COLOR);
-		}
-		else if (c->m_water)
-		{
-			polygon.setFillColor(LAKE_COLOR);
-		}
-		else
-		{
-			polygon.setFillColor(ELEVATION_COLOR[static_cast<int>(floor(c->m_elevation * 10))]);
-		}
-		break;
-	case InfoShown::Name::Moisture:
-		if (c->m_ocean)
-		{
-			polygon.setFillColor(WATER_COLOR);
-		}
-		else if (c->m_water)
-		{
-			polygon.setFillColor(LAKE_COLOR);
-		}
-		else
-		{
-			polygon.setFillColor(MOISTURE_COLOR[static_cast<int>(floor(c->m_moisture * 10))]);
-		}
-		break;
-	default:
-		break;
+		lines.append(sf::Vertex(sf::Vector2f(static_cast<float>(position.x), static_cast<float>(position.y)), c));
 	}
-
-	polygon.setPosition(0, 0);
-	window->draw(polygon);
 }
\ No newline at end of file